@@ -0,0 +1,218 @@
+#include "config.h"
+#include "ensemble.h"
+#include "thread_pool.h"
+#include <filesystem>
+#include <regex>
+#include <map>
+#include <chrono>
+#include <cstring>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// 后处理工具: 取代 analyze_results.py / plot_R_from_pair_cor*.py 中逐个 glob + np.loadtxt 的流程.
+// 用法: ./analyze <目录 ...> [--fit=100:,1000:65536] [--output=summary.txt] [--threads=0] [--group=replica|all|none]
+//   ./analyze ../output                       单次运行 (2D 驱动程序的输出目录)
+//   ./analyze ../output/sweep --fit=100:,1000: simulate 扫描: 名字只差 _r<k> 的任务合成一个系综
+// 在各目录下递归寻找含 t_vs_R.txt 的运行目录, 多线程读取 t_vs_R.txt (能量法 R) 与 Cr_t_*.txt
+// (C(r) 第一个零点, 与 find_first_zero 相同的线性插值), 按组求系综均值与标准误差, 并在每个拟合窗口内
+// 拟合 log R - log t 的斜率: 每次运行各拟合一次, 组内取均值 ± 标准误差 (单次运行时为回归的标准误差).
+// 结果写成一个文件 (默认第一个目录下的 summary.txt, 读取见 summary.py):
+//   series  组  t  n  R_energy  err  R_zero  err
+//   fit     组  量  t_min  t_max  运行数  斜率  err  截距 (ln R = 截距 + 斜率 ln t, 组内均值)
+// 分组: replica (默认) 去掉目录名末尾的 _r<k>; all 全部合成一组; none 每次运行单独一组
+
+struct RunData {
+    string group;
+    vector<long long> t_energy, t_zero;
+    vector<double> R_energy, R_zero;
+    bool ok = false;
+};
+
+// 整个文件读入内存后逐行 strtod, 只取前两列; 跳过 # 注释与空行
+static bool read_two_columns(const string& path, vector<double>& x, vector<double>& y) {
+    ifstream in(path, ios::binary);
+    if (!in.is_open()) return false;
+    string buf((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    const char* p = buf.c_str();
+    const char* end = p + buf.size();
+    while (p < end) {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (!eol) eol = end;
+        while (p < eol && (*p == ' ' || *p == '\t')) ++p;
+        if (p < eol && *p != '#' && *p != '\r') {
+            char* q;
+            double a = strtod(p, &q);
+            if (q != p) {
+                char* r;
+                double b = strtod(q, &r);
+                if (r != q) { x.push_back(a); y.push_back(b); }
+            }
+        }
+        p = eol + 1;
+    }
+    return true;
+}
+
+static RunData analyze_run(const fs::path& dir, const string& group) {
+    RunData run;
+    run.group = group;
+    vector<double> t, R;
+    if (!read_two_columns((dir / "t_vs_R.txt").string(), t, R)) return run;
+    for (size_t i = 0; i < t.size(); ++i) { run.t_energy.push_back((long long)t[i]); run.R_energy.push_back(R[i]); }
+
+    // Cr_t_<t>.txt (轴向 C(r)); 文件名中的 t 决定顺序, 不依赖目录遍历的顺序
+    vector<pair<long long, fs::path>> files;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        const string name = entry.path().filename().string();
+        if (name.size() <= 9 || name.compare(0, 5, "Cr_t_") != 0 || name.compare(name.size() - 4, 4, ".txt") != 0) continue;
+        const string num = name.substr(5, name.size() - 9);
+        if (num.find_first_not_of("0123456789") != string::npos) continue;
+        files.emplace_back(stoll(num), entry.path());
+    }
+    sort(files.begin(), files.end());
+    for (const auto& [mcs, path] : files) {
+        if (mcs == 0) continue; // 初始随机构型没有零点
+        vector<double> r, c;
+        if (!read_two_columns(path.string(), r, c)) continue;
+        double z = first_zero(r, c);
+        if (z > 0) { run.t_zero.push_back(mcs); run.R_zero.push_back(z); }
+    }
+    run.ok = true;
+    return run;
+}
+
+// "100:,1000:65536" -> [(100, inf), (1000, 65536)]
+static vector<pair<double, double>> parse_windows(const vector<string>& items) {
+    vector<pair<double, double>> w;
+    for (const string& s : items) {
+        size_t colon = s.find(':');
+        double lo = stod(s.substr(0, colon));
+        double hi = (colon == string::npos || colon + 1 == s.size()) ? HUGE_VAL : stod(s.substr(colon + 1));
+        w.emplace_back(lo, hi);
+    }
+    return w;
+}
+
+struct GroupSummary {
+    int runs = 0;
+    map<long long, RunningStats> R_energy, R_zero;
+    vector<RunningStats> slope_energy, slope_zero, icpt_energy, icpt_zero;
+    vector<LogLogFit> single_energy, single_zero; // 只有一次运行时用回归的标准误差
+};
+
+int main(int argc, char** argv) {
+    Config cfg;
+    vector<string> roots;
+    for (int k = 1; k < argc; ++k) {
+        string a = argv[k];
+        if (a.rfind("--", 0) == 0 && a.find('=') != string::npos) {
+            size_t eq = a.find('=');
+            cfg.set(a.substr(2, eq - 2), a.substr(eq + 1));
+        } else {
+            roots.push_back(a);
+        }
+    }
+    if (roots.empty()) {
+        cerr << "用法: " << argv[0] << " <目录 ...> [--fit=100:] [--output=summary.txt] [--threads=0] [--group=replica|all|none]" << endl;
+        return 1;
+    }
+    const auto windows = parse_windows(cfg.list("fit", "100:"));
+    const string grouping = cfg.get("group", "replica");
+    const string output = cfg.get("output", (fs::path(roots[0]) / "summary.txt").string());
+    auto start = chrono::high_resolution_clock::now();
+
+    // 1. 找出全部运行目录 (含 t_vs_R.txt), 组名为相对第一个参数目录的路径
+    const regex replica_suffix("_r[0-9]+$");
+    vector<pair<fs::path, string>> runs;
+    auto add_run = [&](const fs::path& dir, const fs::path& root) {
+        // 参数目录本身是一次运行时取它的目录名 ("../output/" -> "output")
+        fs::path abs = fs::absolute(dir).lexically_normal();
+        if (!abs.has_filename()) abs = abs.parent_path();
+        string rel = dir == root ? abs.filename().string() : fs::relative(dir, root).generic_string();
+        string group = grouping == "all" ? "all" : grouping == "none" ? rel : regex_replace(rel, replica_suffix, "");
+        runs.emplace_back(dir, group);
+    };
+    for (const string& r : roots) {
+        fs::path root(r);
+        if (!fs::is_directory(root)) { cerr << "不是目录: " << r << endl; return 1; }
+        if (fs::exists(root / "t_vs_R.txt")) add_run(root, root);
+        for (auto it = fs::recursive_directory_iterator(root); it != fs::recursive_directory_iterator(); ++it) {
+            if (it->is_directory() && fs::exists(it->path() / "t_vs_R.txt")) add_run(it->path(), root);
+        }
+    }
+    if (runs.empty()) { cerr << "没有找到含 t_vs_R.txt 的运行目录" << endl; return 1; }
+
+    // 2. 多线程读取与逐次运行的分析
+    vector<RunData> data(runs.size());
+    atomic<size_t> next(0);
+    WorkerPool pool((int)cfg.get("threads", 0LL));
+    pool.run([&](int) {
+        for (size_t k; (k = next.fetch_add(1)) < runs.size();) data[k] = analyze_run(runs[k].first, runs[k].second);
+    });
+
+    // 3. 按组汇总: 各时刻的均值与误差, 每次运行各窗口的斜率
+    map<string, GroupSummary> groups;
+    for (const RunData& run : data) {
+        if (!run.ok) continue;
+        GroupSummary& g = groups[run.group];
+        if (g.runs++ == 0) {
+            g.slope_energy.resize(windows.size()); g.slope_zero.resize(windows.size());
+            g.icpt_energy.resize(windows.size()); g.icpt_zero.resize(windows.size());
+            g.single_energy.resize(windows.size()); g.single_zero.resize(windows.size());
+        }
+        for (size_t i = 0; i < run.t_energy.size(); ++i) g.R_energy[run.t_energy[i]].add(run.R_energy[i]);
+        for (size_t i = 0; i < run.t_zero.size(); ++i) g.R_zero[run.t_zero[i]].add(run.R_zero[i]);
+        for (size_t w = 0; w < windows.size(); ++w) {
+            LogLogFit fe = loglog_fit(run.t_energy, run.R_energy, windows[w].first, windows[w].second);
+            LogLogFit fz = loglog_fit(run.t_zero, run.R_zero, windows[w].first, windows[w].second);
+            if (fe.n >= 2) { g.slope_energy[w].add(fe.slope); g.icpt_energy[w].add(fe.intercept); g.single_energy[w] = fe; }
+            if (fz.n >= 2) { g.slope_zero[w].add(fz.slope); g.icpt_zero[w].add(fz.intercept); g.single_zero[w] = fz; }
+        }
+    }
+
+    // 4. 汇总文件
+    ofstream out(output);
+    if (!out.is_open()) { cerr << "无法写入: " << output << endl; return 1; }
+    out << "# analyze: " << runs.size() << " runs, " << groups.size() << " groups\n";
+    out << "# series\tgroup\tt\tn\tR_energy\terr\tR_zero\terr\n";
+    out << "# fit\tgroup\tobservable\tt_min\tt_max\truns\tslope\terr\tintercept\n";
+    out << setprecision(8);
+    for (const auto& [name, g] : groups) {
+        map<long long, pair<const RunningStats*, const RunningStats*>> rows;
+        for (const auto& [t, s] : g.R_energy) rows[t].first = &s;
+        for (const auto& [t, s] : g.R_zero) rows[t].second = &s;
+        for (const auto& [t, row] : rows) {
+            const RunningStats empty;
+            const RunningStats& e = row.first ? *row.first : empty;
+            const RunningStats& z = row.second ? *row.second : empty;
+            out << "series\t" << name << "\t" << t << "\t" << max(e.n, z.n)
+                << "\t" << (e.n ? e.mean() : NAN) << "\t" << e.sem() << "\t" << (z.n ? z.mean() : NAN) << "\t" << z.sem() << "\n";
+        }
+        for (size_t w = 0; w < windows.size(); ++w) {
+            auto write_fit = [&](const char* obs, const RunningStats& slope, const RunningStats& icpt, const LogLogFit& single) {
+                if (slope.n == 0) return;
+                out << "fit\t" << name << "\t" << obs << "\t" << windows[w].first << "\t";
+                if (isinf(windows[w].second)) out << "inf"; else out << windows[w].second;
+                out << "\t" << slope.n << "\t" << slope.mean() << "\t" << (slope.n > 1 ? slope.sem() : single.err)
+                    << "\t" << icpt.mean() << "\n";
+            };
+            write_fit("R_energy", g.slope_energy[w], g.icpt_energy[w], g.single_energy[w]);
+            write_fit("R_zero", g.slope_zero[w], g.icpt_zero[w], g.single_zero[w]);
+        }
+    }
+
+    double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+    cout << runs.size() << " run(s) in " << groups.size() << " group(s), " << pool.size() << " thread(s), "
+         << seconds << " s -> " << output << endl;
+    if (groups.size() > 20) return 0; // 组很多时只看汇总文件
+    for (const auto& [name, g] : groups) {
+        for (size_t w = 0; w < windows.size(); ++w) {
+            if (g.slope_energy[w].n == 0) continue;
+            const RunningStats& s = g.slope_energy[w];
+            cout << name << " [" << windows[w].first << ", " << windows[w].second << "]: R_energy slope = " << s.mean()
+                 << " ± " << (s.n > 1 ? s.sem() : g.single_energy[w].err) << " (" << g.runs << " run(s))" << endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+#ifndef ASYNC_PIPELINE_H
+#define ASYNC_PIPELINE_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+// 异步测量 / 输出流水线: 采样时刻主循环只把晶格复制进一个空闲快照缓冲区 (O(N) memcpy)
+// 就继续下一个 MCS, 后台线程并行计算 C(r)、S(k), 再按提交顺序串行写文件.
+//
+//   Snap& s = pipe.acquire();  // 没有空闲缓冲区时阻塞 (有界队列的反压)
+//   s.mcs = ...; s.sites = engine.sites; ...
+//   pipe.submit(s);
+//
+// analyze(snap, worker) 在各工作线程中并行执行 (worker 用于选取线程私有的工作区);
+// commit(snap) 严格按 submit 的顺序、一次一个地执行, 输出文件的行顺序与同步版本相同.
+// drain() 等待所有已提交的快照写完, 写检查点前调用.
+template <class Snap>
+class AsyncPipeline {
+public:
+    AsyncPipeline(int n_buffers, int n_workers, function<void(Snap&, int)> analyze_, function<void(Snap&)> commit_)
+        : buffers(n_buffers), analyze(analyze_), commit(commit_) {
+        for (auto& b : buffers) free_list.push_back(&b);
+        for (int w = 0; w < n_workers; ++w) threads.emplace_back([this, w] { loop(w); });
+    }
+
+    ~AsyncPipeline() {
+        drain();
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        cv_work.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    Snap& acquire() {
+        unique_lock<mutex> lock(m);
+        cv_free.wait(lock, [this] { return !free_list.empty(); });
+        Snap* s = free_list.back();
+        free_list.pop_back();
+        return *s;
+    }
+
+    void submit(Snap& s) {
+        {
+            lock_guard<mutex> lock(m);
+            queue.push_back({&s, next_seq++});
+        }
+        cv_work.notify_one();
+    }
+
+    void drain() {
+        unique_lock<mutex> lock(m);
+        cv_free.wait(lock, [this] { return committed == next_seq; });
+    }
+
+private:
+    struct Job { Snap* snap; long long seq; };
+
+    vector<Snap> buffers;
+    function<void(Snap&, int)> analyze;
+    function<void(Snap&)> commit;
+    vector<thread> threads;
+    mutex m;
+    condition_variable cv_work, cv_free, cv_turn;
+    vector<Snap*> free_list;
+    deque<Job> queue;
+    long long next_seq = 0, committed = 0;
+    bool stopping = false;
+
+    void loop(int w) {
+        while (true) {
+            Job job;
+            {
+                unique_lock<mutex> lock(m);
+                cv_work.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) return;
+                job = queue.front();
+                queue.pop_front();
+            }
+            analyze(*job.snap, w);
+            {
+                // 等待轮到自己: 写出顺序与提交顺序一致
+                unique_lock<mutex> lock(m);
+                cv_turn.wait(lock, [&] { return committed == job.seq; });
+            }
+            commit(*job.snap);
+            {
+                lock_guard<mutex> lock(m);
+                ++committed;
+                free_list.push_back(job.snap);
+            }
+            cv_turn.notify_all();
+            cv_free.notify_all();
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,401 @@
+#include "functions.h"
+#include "functions_3d.h"
+#include "kawasaki_engine.h"
+#include "multispin_kawasaki.h"
+#include "structure_factor.h"
+#include "trajectory.h"
+#include "config.h"
+#include "fast_forward.h"
+#include "interleaved.h"
+#include <chrono>
+#include <filesystem>
+#include <functional>
+
+// 基线 Kawasaki 程序的辅助函数放在独立的命名空间里, 避免与 functions.h 同名
+namespace baseline {
+#include "../baseline/functions_kawasaki.h"
+}
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// 基准测试: 固定种子的输入晶格, 分别计时热点内核, 结果写成 JSON 以便比较不同构建.
+// 用法: ./benchmark [--quick=1] [--out=bench.json] [--compare=old.json] [--tolerance=0.1] [--filter=子串]
+//   rng            32 位随机数, ns/draw (batched: BatchedRng; mt19937)
+//   vacancy_hop    空位跳跃核, ns/attempt (metropolis / rejection_free / packed; triangular / bcc / fcc 几何;
+//                  slab / fast_forward: 两块平直畴的构型 (后期粗化的代表) 上的 Metropolis 核与快进核;
+//                  row_major / morton: 大晶格上两种格点存储顺序, 见 lattice.h;
+//                  interleaved_<顺序>_K: K 个副本在一个线程内交错推进, 见 interleaved.h)
+//   kawasaki_hop   Kawasaki 交换, ns/attempt (baseline: baseline/kawasaki_dynamic.cpp 的内层循环; engine: KawasakiEngine;
+//                  bond_list / bond_rf: KawasakiBondEngine 的界面键列表与无拒绝模式;
+//                  multispin: MultispinKawasakiEngine, 按每个副本的尝试计)
+//   correlation    C(r), ms/call (scan: calculate_C_r / calculate_C_r_3d; baseline; packed; fft: StructureFactor::measure)
+//   total_energy   全局能量, ms/call (scan: get_total_energy / get_total_energy_3d; packed)
+//   snapshot       快照写出, Msites/s (text: write_lattice; trajectory; trajectory_rle)
+// 每项重复到累计至少 min_time 秒 (且至少 3 次), 取单次耗时的中位数.
+// --compare 时逐项对比旧 JSON, 变慢超过 tolerance 的项列为回归, 返回码为 1
+
+const uint64_t bench_seed = 20240601; // 所有输入晶格由此种子生成, 不同机器上输入相同
+
+struct BenchResult {
+    string name, variant, unit;
+    int D, L;
+    double value;
+    int reps;
+
+    string key() const { return name + "/" + variant + "/" + to_string(D) + "d/L" + to_string(L); }
+    bool higher_is_better() const { return unit == "Msites/s"; }
+};
+
+struct BenchOptions {
+    bool quick = false;
+    double min_time = 0.3;
+    string filter;
+};
+
+vector<BenchResult> results;
+
+// 重复执行 f 直到累计至少 min_time 秒且至少 min_reps 次, 返回单次耗时的中位数 (秒)
+template <class F>
+double time_median(F&& f, double min_time, int& reps, int min_reps = 3) {
+    vector<double> t;
+    double total = 0.0;
+    while ((int)t.size() < min_reps || total < min_time) {
+        auto start = chrono::high_resolution_clock::now();
+        f();
+        t.push_back(chrono::duration<double>(chrono::high_resolution_clock::now() - start).count());
+        total += t.back();
+    }
+    reps = (int)t.size();
+    nth_element(t.begin(), t.begin() + t.size() / 2, t.end());
+    return t[t.size() / 2];
+}
+
+// 计时并记录一项; scale 把单次秒数换算成报告的单位
+template <class F>
+void record(const BenchOptions& opt, const string& name, const string& variant, int D, int L,
+            const string& unit, F&& f, function<double(double)> scale) {
+    BenchResult r{name, variant, unit, D, L, 0.0, 0};
+    if (!opt.filter.empty() && r.key().find(opt.filter) == string::npos) return;
+    double s = time_median(f, opt.min_time, r.reps);
+    r.value = scale(s);
+    results.push_back(r);
+    cout << left << setw(40) << r.key() << right << setw(12) << setprecision(4) << r.value << " " << unit << endl;
+}
+
+// baseline/kawasaki_dynamic.cpp 中一个 MCS 的内层循环, 逐行对应 (浮点 dE + exp, 交换后重算邻居和)
+void baseline_kawasaki_sweep(vector<int>& lattice, int L, double J, double T, long long n_attempts, mt19937& gen) {
+    for (long long step = 0; step < n_attempts; ++step) {
+        int idx1 = uniform_int_distribution<int>(0, L * L - 1)(gen);
+        int x1 = idx1 / L;
+        int y1 = idx1 % L;
+        int dir = uniform_int_distribution<int>(0, 3)(gen);
+        int x2 = x1, y2 = y1;
+        if (dir == 0) x2++; else if (dir == 1) x2--;
+        else if (dir == 2) y2++; else y2--;
+        int idx2 = baseline::get_idx(x2, y2, L);
+        if (lattice[idx1] != lattice[idx2]) {
+            int s1 = lattice[idx1];
+            int s2 = lattice[idx2];
+            int sum1 = baseline::get_neighbor_sum(lattice, idx1, L);
+            int sum2 = baseline::get_neighbor_sum(lattice, idx2, L);
+            double e_old = -J * (s1 * sum1 + s2 * sum2);
+            lattice[idx1] = s2;
+            lattice[idx2] = s1;
+            int sum1_new = baseline::get_neighbor_sum(lattice, idx1, L);
+            int sum2_new = baseline::get_neighbor_sum(lattice, idx2, L);
+            double e_new = -J * (s2 * sum1_new + s1 * sum2_new);
+            double dE = e_new - e_old;
+            if (!(dE <= 0 || uniform_real_distribution<double>(0, 1)(gen) < exp(-dE / T))) {
+                lattice[idx1] = s1;
+                lattice[idx2] = s2;
+            }
+        }
+    }
+}
+
+// 随机数发生器本身: 每次抽取的耗时 (D, L 记为 0)
+void bench_rng(const BenchOptions& opt) {
+    const long long draws = 1LL << 24;
+    auto per_draw = [&](double s) { return s * 1e9 / draws; };
+    volatile uint32_t sink = 0;
+    Rng fast = make_stream(bench_seed, 3);
+    record(opt, "rng", "batched", 0, 0, "ns/draw", [&] {
+        uint32_t x = 0;
+        for (long long k = 0; k < draws; ++k) x += fast();
+        sink = sink + x;
+    }, per_draw);
+    mt19937 mt(bench_seed);
+    record(opt, "rng", "mt19937", 0, 0, "ns/draw", [&] {
+        uint32_t x = 0;
+        for (long long k = 0; k < draws; ++k) x += mt();
+        sink = sink + x;
+    }, per_draw);
+}
+
+// 跳跃核: 先从固定种子的随机构型出发在 T = Tc/2 下预热 warm_mcs, 再计时 (接受率接近淬火后的典型值)
+template <int D, int CL>
+void bench_hops(const BenchOptions& opt) {
+    const double T = critical_temperature(default_geometry(D), D) / 2.0, J = 1.0;
+    const int warm_mcs = 4;
+    const long long attempts = opt.quick ? (1LL << 20) : (1LL << 22);
+    auto per_attempt = [&](double s) { return s * 1e9 / attempts; };
+
+    {
+        Rng gen = make_stream(bench_seed, 0);
+        VacancyEngine<D, CL> e(CL, T, J);
+        e.initialize(gen);
+        for (int k = 0; k < warm_mcs; ++k) e.mcs(gen);
+        record(opt, "vacancy_hop", "metropolis", D, CL, "ns/attempt", [&] { e.sweep(attempts, gen); }, per_attempt);
+        record(opt, "vacancy_hop", "rejection_free", D, CL, "ns/attempt", [&] { e.sweep_rejection_free(attempts, gen); }, per_attempt);
+    }
+    {
+        Rng gen = make_stream(bench_seed, 0);
+        VacancyEngine<D, CL, PackedSites> e(CL, T, J);
+        e.initialize(gen);
+        for (int k = 0; k < warm_mcs; ++k) e.mcs(gen);
+        record(opt, "vacancy_hop", "packed", D, CL, "ns/attempt", [&] { e.sweep(attempts, gen); }, per_attempt);
+    }
+    {
+        // 沿第 0 轴分成两半的平直畴, 预热后大部分尝试落在畴内部
+        Rng gen = make_stream(bench_seed, 0);
+        VacancyEngine<D, CL> e(CL, T, J);
+        e.initialize(gen);
+        for_each_site(e.lat, [&](int i, const auto& c) { if (e.sites[i] != 0) e.sites[i] = c[0] < CL / 2 ? 1 : -1; });
+        e.energy = total_energy_bonds(e.lat, e.sites);
+        for (int k = 0; k < warm_mcs; ++k) e.mcs(gen);
+        record(opt, "vacancy_hop", "slab", D, CL, "ns/attempt", [&] { e.sweep(attempts, gen); }, per_attempt);
+        CoarseGrid<typename VacancyEngine<D, CL>::lattice_type> grid(e.lat, 4);
+        grid.rebuild(e.lat, e.sites);
+        BulkWalk<typename VacancyEngine<D, CL>::lattice_type> bulk(e.lat, grid);
+        record(opt, "vacancy_hop", "fast_forward", D, CL, "ns/attempt",
+               [&] { e.energy += vacancy_sweep_fast_forward(e.lat, e.table, e.sites, e.vc, e.v_pos, attempts, gen, bulk); }, per_attempt);
+    }
+    // 非超立方几何 (偏移表路径), 同样的 T/Tc
+    auto bench_geometry = [&](auto geometry, const char* variant, const char* name) {
+        using G = decltype(geometry);
+        Rng gen = make_stream(bench_seed, 0);
+        VacancyEngine<D, CL, vector<int>, G> e(CL, critical_temperature(name, D) / 2.0, J);
+        e.initialize(gen);
+        for (int k = 0; k < warm_mcs; ++k) e.mcs(gen);
+        record(opt, "vacancy_hop", variant, D, CL, "ns/attempt", [&] { e.sweep(attempts, gen); }, per_attempt);
+    };
+    if constexpr (D == 2) {
+        bench_geometry(Triangular(), "triangular", "triangular");
+    } else {
+        bench_geometry(BCC(), "bcc", "bcc");
+        bench_geometry(FCC(), "fcc", "fcc");
+    }
+    {
+        Rng gen = make_stream(bench_seed, 1);
+        KawasakiEngine<D, CL> e(CL, T, J);
+        e.initialize(gen);
+        for (int k = 0; k < warm_mcs; ++k) e.mcs(gen);
+        record(opt, "kawasaki_hop", "engine", D, CL, "ns/attempt", [&] { e.sweep(attempts, gen); }, per_attempt);
+        if constexpr (D == 2) {
+            vector<int> lattice = e.sites;
+            mt19937 base_gen(bench_seed); // 基线程序使用 mt19937 + 标准库分布
+            record(opt, "kawasaki_hop", "baseline", D, CL, "ns/attempt",
+                   [&] { baseline_kawasaki_sweep(lattice, CL, J, T, attempts, base_gen); }, per_attempt);
+        }
+    }
+    {
+        Rng gen = make_stream(bench_seed, 1);
+        KawasakiBondEngine<D, CL> e(CL, T, J);
+        e.initialize(gen);
+        for (int k = 0; k < warm_mcs; ++k) e.mcs(gen);
+        record(opt, "kawasaki_hop", "bond_list", D, CL, "ns/attempt", [&] { e.sweep(attempts, gen); }, per_attempt);
+        e.rejection_free = true;
+        record(opt, "kawasaki_hop", "bond_rf", D, CL, "ns/attempt", [&] { e.sweep(attempts, gen); }, per_attempt);
+    }
+    {
+        Rng gen = make_stream(bench_seed, 1);
+        MultispinKawasakiEngine<D, CL> e(CL, T, J);
+        e.initialize(gen);
+        for (int k = 0; k < warm_mcs; ++k) e.mcs(gen);
+        const long long n = attempts / e.replicas * 16; // 每次尝试推进全部副本
+        record(opt, "kawasaki_hop", "multispin", D, CL, "ns/attempt", [&] { e.sweep(n, gen); },
+               [&](double s) { return s * 1e9 / ((double)n * e.replicas); });
+    }
+}
+
+// 格点存储顺序: 大晶格上行优先与 Morton 顺序的同一 Metropolis 核 (同一种子的随机合金, 预热 warm 次尝试;
+// 大 L 下按 MCS 预热太慢, 而跳跃的访存模式只取决于空位附近的局部构型)
+template <int D, int CL>
+void bench_order(const BenchOptions& opt) {
+    const double T = critical_temperature(default_geometry(D), D) / 2.0, J = 1.0;
+    const long long attempts = opt.quick ? (1LL << 20) : (1LL << 22), warm = 4 * attempts;
+    auto per_attempt = [&](double s) { return s * 1e9 / attempts; };
+    auto bench = [&](auto order, const char* variant) {
+        Rng gen = make_stream(bench_seed, 0);
+        VacancyEngine<D, CL, vector<int>, HyperCubic<D>, decltype(order)> e(CL, T, J);
+        e.initialize(gen);
+        e.sweep(warm, gen);
+        record(opt, "vacancy_hop", variant, D, CL, "ns/attempt", [&] { e.sweep(attempts, gen); }, per_attempt);
+    };
+    bench(RowMajor(), "row_major");
+    bench(Morton(), "morton");
+}
+
+// 多副本交错执行 (interleaved.h): K 个副本在一个线程内轮流推进, 按每个副本的尝试计;
+// 与 bench_order 中同一 L、同一顺序的单副本结果对比
+template <int D, int CL>
+void bench_interleaved(const BenchOptions& opt, int K) {
+    const double T = critical_temperature(default_geometry(D), D) / 2.0, J = 1.0;
+    const long long attempts = opt.quick ? (1LL << 18) : (1LL << 20), warm = 4 * attempts;
+    auto bench = [&](auto order, const char* variant) {
+        using Engine = VacancyEngine<D, CL, vector<int>, HyperCubic<D>, decltype(order)>;
+        vector<Engine> engines;
+        vector<Rng> gens;
+        for (int k = 0; k < K; ++k) {
+            gens.push_back(make_stream(bench_seed, k));
+            engines.emplace_back(CL, T, J);
+            engines[k].initialize(gens[k]);
+        }
+        interleaved_sweep(engines, gens, warm);
+        record(opt, "vacancy_hop", variant + to_string(K), D, CL, "ns/attempt", [&] { interleaved_sweep(engines, gens, attempts); },
+               [&](double s) { return s * 1e9 / ((double)attempts * K); });
+    };
+    bench(RowMajor(), "interleaved_row_major_");
+    bench(Morton(), "interleaved_morton_");
+}
+
+// 测量函数: 固定种子的随机合金 (T = ∞ 构型), 与 t = 0 时刻的采样输入相同
+template <int D>
+void bench_measurements(const BenchOptions& opt, int L, const fs::path& tmp) {
+    Lattice<D> lat(L);
+    Rng gen = make_stream(bench_seed, 2);
+    vector<int> sites;
+    int v_pos;
+    fill_random_alloy(lat, sites, v_pos, gen);
+    PackedSites packed;
+    unpack_sites(pack_sites(sites, lat.sites()), lat.sites(), v_pos, packed);
+    auto ms = [](double s) { return s * 1e3; };
+    auto msites = [&](double s) { return lat.sites() / s / 1e6; };
+    volatile double sink = 0.0; // 防止结果被优化掉
+
+    if constexpr (D == 2) {
+        record(opt, "correlation", "scan", D, L, "ms", [&] { sink = sink + calculate_C_r(sites, L)[1]; }, ms);
+        vector<int> full = sites;
+        full[v_pos] = 1; // 基线版本没有空位
+        record(opt, "correlation", "baseline", D, L, "ms", [&] { sink = sink + baseline::calculate_C_r(full, L)[1]; }, ms);
+        record(opt, "total_energy", "scan", D, L, "ms", [&] { sink = sink + get_total_energy(sites, L, 1.0); }, ms);
+    } else {
+        record(opt, "correlation", "scan", D, L, "ms", [&] { sink = sink + calculate_C_r_3d(sites, L)[1]; }, ms);
+        record(opt, "total_energy", "scan", D, L, "ms", [&] { sink = sink + get_total_energy_3d(sites, L, 1.0); }, ms);
+    }
+    if (packed_popcount_ok(lat)) {
+        record(opt, "correlation", "packed", D, L, "ms", [&] { sink = sink + axial_correlation(lat, packed)[1]; }, ms);
+        record(opt, "total_energy", "packed", D, L, "ms", [&] { sink = sink + total_energy_bonds(lat, packed); }, ms);
+    }
+    StructureFactor<Lattice<D>> sf(lat);
+    record(opt, "correlation", "fft", D, L, "ms", [&] { sink = sink + sf.measure(sites).R_zero; }, ms);
+
+    string text = (tmp / "lattice.txt").string(), traj = (tmp / "trajectory.bin").string();
+    record(opt, "snapshot", "text", D, L, "Msites/s", [&] { write_lattice(lat, sites, text); }, msites);
+    {
+        TrajectoryWriter w(traj, D, L, default_geometry(D), 1.0, 1.0, bench_seed);
+        record(opt, "snapshot", "trajectory", D, L, "Msites/s", [&] { w.write_frame(0, sites, v_pos); w.flush(); }, msites);
+    }
+    {
+        TrajectoryWriter w(traj, D, L, default_geometry(D), 1.0, 1.0, bench_seed, true);
+        record(opt, "snapshot", "trajectory_rle", D, L, "Msites/s", [&] { w.write_frame(0, sites, v_pos); w.flush(); }, msites);
+    }
+}
+
+// 每个结果占一行, compare 按行解析 (不需要通用 JSON 库)
+void write_json(const string& path, const BenchOptions& opt) {
+    ofstream out(path);
+    out << "{\n  \"benchmark\": \"vacancy_mediated_dynamics\",\n  \"version\": 1,\n"
+        << "  \"seed\": " << bench_seed << ",\n  \"quick\": " << (opt.quick ? "true" : "false") << ",\n"
+        << "  \"compiler\": \"" << __VERSION__ << "\",\n"
+        << "  \"hardware_threads\": " << thread::hardware_concurrency() << ",\n"
+        << "  \"results\": [\n";
+    for (size_t k = 0; k < results.size(); ++k) {
+        const BenchResult& r = results[k];
+        out << "    {\"key\": \"" << r.key() << "\", \"name\": \"" << r.name << "\", \"variant\": \"" << r.variant
+            << "\", \"D\": " << r.D << ", \"L\": " << r.L << ", \"value\": " << setprecision(6) << r.value
+            << ", \"unit\": \"" << r.unit << "\", \"reps\": " << r.reps << "}" << (k + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+inline string json_field(const string& line, const string& field) {
+    size_t p = line.find("\"" + field + "\": ");
+    if (p == string::npos) return "";
+    p += field.size() + 4;
+    if (line[p] == '"') return line.substr(p + 1, line.find('"', p + 1) - p - 1);
+    return line.substr(p, line.find_first_of(",}", p) - p);
+}
+
+// 返回回归项数
+int compare_json(const string& path, double tolerance) {
+    ifstream in(path);
+    if (!in.is_open()) { cerr << "无法打开对比文件: " << path << endl; return -1; }
+    map<string, double> old;
+    for (string line; getline(in, line);) {
+        string key = json_field(line, "key");
+        if (!key.empty()) old[key] = stod(json_field(line, "value"));
+    }
+    int regressions = 0;
+    cout << "\nComparison with " << path << " (tolerance " << tolerance * 100 << "%):" << endl;
+    for (const BenchResult& r : results) {
+        auto it = old.find(r.key());
+        if (it == old.end() || it->second <= 0) continue;
+        // speedup > 1 表示比旧构建快
+        double speedup = r.higher_is_better() ? r.value / it->second : it->second / r.value;
+        bool regressed = speedup < 1.0 - tolerance;
+        regressions += regressed;
+        cout << left << setw(40) << r.key() << right << setw(10) << setprecision(3) << speedup << "x"
+             << (regressed ? "  REGRESSION" : "") << endl;
+    }
+    cout << regressions << " regression(s)" << endl;
+    return regressions;
+}
+
+int main(int argc, char** argv) {
+    Config cfg;
+    if (!cfg.parse_args(argc, argv)) return 1;
+    BenchOptions opt;
+    opt.quick = cfg.get("quick", 0LL) != 0;
+    opt.min_time = cfg.get("min_time", opt.quick ? 0.05 : 0.3);
+    opt.filter = cfg.get("filter", "");
+    string out = cfg.get("out", "benchmark.json");
+
+    fs::path tmp = fs::temp_directory_path() / "vmd_benchmark";
+    fs::create_directories(tmp);
+
+    bench_rng(opt);
+
+    // 跳跃核: 编译期 L (与驱动程序相同的实例化方式)
+    bench_hops<2, 64>(opt);
+    bench_hops<2, 128>(opt);
+    bench_hops<2, 256>(opt);
+    bench_hops<3, 32>(opt);
+    bench_hops<3, 64>(opt);
+    if (!opt.quick) {
+        bench_hops<2, 1024>(opt);
+        bench_hops<3, 128>(opt);
+    }
+    bench_order<3, 128>(opt);
+    bench_order<3, 256>(opt);
+    bench_interleaved<3, 256>(opt, 8);
+    if (!opt.quick) {
+        bench_order<3, 512>(opt);
+        bench_order<2, 4096>(opt);
+    }
+
+    // 测量与输出: C(r) 等随 L 的标度
+    for (int L : opt.quick ? vector<int>{64, 128} : vector<int>{64, 128, 256, 512}) bench_measurements<2>(opt, L, tmp);
+    for (int L : opt.quick ? vector<int>{16, 32} : vector<int>{16, 32, 64, 128}) bench_measurements<3>(opt, L, tmp);
+
+    fs::remove_all(tmp);
+    write_json(out, opt);
+    cout << "\nResults written to " << out << endl;
+
+    if (cfg.has("compare")) {
+        int regressions = compare_json(cfg.get("compare", ""), cfg.get("tolerance", 0.1));
+        if (regressions != 0) return 1;
+    }
+    return 0;
+}
@@ -1,82 +1,200 @@
 #include "functions.h"
+#include "structure_factor.h"
+#include "checkpoint.h"
+#include "trajectory.h"
+#include "async_pipeline.h"
+#include "instrumentation.h"
+#include "coarse_grain.h"
+#include "fast_forward.h"
+#include "live_view.h"
 #include <chrono>
+#include <deque>
 #include <math.h>
 
 using namespace std;
 
-int main() {
+// 用法: ./binary_alloys_2D [--resume]
+int main(int argc, char** argv) {
     const int L = 128;
     const double Tc = 2.269, T = Tc / 2.0, J = 1.0;
     const int num_mc = pow(2,20); //33000;
+    const bool axial_Cr_compat = true; // 兼容模式: 继续输出轴向 Cr_t_X.txt
+    const double checkpoint_interval = 600.0; // 每 10 分钟写一次检查点
+    const string checkpoint_file = "../output/checkpoint.bin";
+    const string trajectory_file = "../output/trajectory.bin"; // 晶格快照 (二进制, 见 trajectory.h)
+    const bool compress_frames = false; // 帧的无损游程压缩; 关闭时 Python 端可直接 memmap
+    const bool instrument = false; // 热路径插桩: 按 de 的接受率、空位 MSD、分阶段计时与硬件计数器 (见 instrumentation.h)
+    const string instrument_file = "../output/instrumentation.jsonl"; // 与 t_vs_R.txt 同目录, 每个采样时刻一行
+    const int coarse_block = 4; // 粗粒化块边长 b: 块自旋和随每次跳跃增量更新 (见 coarse_grain.h)
+    const int dense_per_decade = 20; // 稠密采样 t_vs_R_dense.txt: 每十倍 MCS 的点数 (0 为每个 MCS)
+    const bool fast_forward = false; // 纯畴内空位随机行走按首达分布整段快进 (见 fast_forward.h), 只用于 Metropolis 核;
+                                     // L = 128 时到 R ≈ 20 仍与普通核持平, 大畴 (两条带, L = 256) 时约 1.4 倍
+    const bool live_view = true; // 共享内存实时视图 /dev/shm/vmd_live_2d_<pid> (见 live_view.h, 读取端 python live_view.py vmd_live_2d); 无读者时每个 MCS 只多一次时间比较
+    const int analysis_threads = 2, snapshot_buffers = 3; // 后台测量线程数 / 快照缓冲区数 (见 async_pipeline.h)
+    const vector<string> outputs = {"../output/t_vs_R.txt", "../output/time_log_1.txt", "../output/t_vs_R_sk.txt", trajectory_file, "../output/domains.txt", instrument_file, "../output/t_vs_R_dense.txt"};
+    const bool resume = argc > 1 && string(argv[1]) == "--resume";
     
-    mt19937 gen(chrono::steady_clock::now().time_since_epoch().count());
-    vector<int> lattice;
-    int vacancy_pos;
-    initialize_lattice(lattice, L, vacancy_pos, gen);
-    
-    double current_energy = get_total_energy(lattice, L, J);
-    ofstream r_file("../output/t_vs_R.txt");
-    ofstream time_log("../output/time_log_1.txt");
+    const uint64_t seed = chrono::steady_clock::now().time_since_epoch().count(); // 记录在轨迹文件头 (续算时沿用原种子)
+    Rng gen(seed); // xoshiro256** 批量生成 (见 rng.h)
+    // L 为编译期常量且是 2 的幂: 周期边界退化为位掩码 (见 lattice.h)
+    VacancyEngine<2, L> engine(L, T, J);
+    int start_mcs = 0;
+    if (resume) {
+        int last_mcs;
+        if (!load_checkpoint(checkpoint_file, engine, last_mcs, gen, outputs)) return 1;
+        start_mcs = last_mcs + 1;
+        cout << "Resumed from MCS " << last_mcs << endl;
+    } else {
+        engine.initialize(gen);
+    }
+    engine.rejection_free = T < 0.35 * Tc; // 低温淬火 (0.2 Tc) 用无拒绝 BKL 核, 动力学相同
+    const int N = engine.sites_count();
+    // 不插桩时 Probe 为 NullProbe, 内核中的探针调用在编译期消除
+    using Probe = conditional_t<instrument, HopProbe<2>, NullProbe>;
+    Probe probe(engine.table);
+    PhaseProfiler profiler(instrument);
+    // 块自旋和作为第二个探针挂在内核上; 检查点只存晶格, 续算后由构型重建
+    CoarseGrid<decltype(engine.lat)> coarse(engine.lat, coarse_block);
+    coarse.rebuild(engine.lat, engine.sites);
+    // 快进时块和由快进核经 bulk 维护, coarse 不再作为探针传入
+    BulkWalk<decltype(engine.lat)> bulk(engine.lat, coarse);
+    // FFT 测量模块, O(N log N); 每个后台线程一份工作区
+    vector<StructureFactor<decltype(engine.lat)>> sf(analysis_threads, StructureFactor<decltype(engine.lat)>(engine.lat));
+    // 畴标记 (并行 union-find, 见 domains.h); 每个后台线程一个, 硬件线程在它们之间平分
+    deque<DomainLabeler<decltype(engine.lat)>> labelers;
+    for (int w = 0; w < analysis_threads; ++w) labelers.emplace_back(engine.lat, max(1, (int)thread::hardware_concurrency() / analysis_threads));
+
+    // 续算时以追加方式打开 (load_checkpoint 已截断到检查点时刻的长度)
+    auto mode = resume ? ios::app : ios::out;
+    ofstream r_file(outputs[0], mode);
+    ofstream time_log(outputs[1], mode);
+    ofstream sk_file(outputs[2], mode); // mcs, 球平均 C(r) 零点, 2π/k̄, k̄
+    ofstream domain_file(outputs[4], mode); // mcs, 畴数, 平均大小, 加权平均大小, 最大畴, 贯穿畴数
+    ofstream dense_file(outputs[6], mode); // mcs, 能量法 R, 异类键数, 粗粒化 C(r) 零点, 粗粒化 2π/k̄, 粗粒化畴数
+    ofstream instrument_log;
+    if (instrument) instrument_log.open(instrument_file, mode);
+    TrajectoryWriter trajectory(trajectory_file, 2, L, HyperCubic<2>::name(), T, J, seed, compress_frames, resume);
+    if (!trajectory.ok()) {
+        cerr << "Cannot " << (resume ? "append to" : "create") << " trajectory file " << trajectory_file << endl;
+        return 1;
+    }
+    CheckpointTimer checkpoint_timer(checkpoint_interval);
+    LiveView live(live_view, "/vmd_live_2d_" + to_string(getpid()), engine.lat, T, J); // 带进程号, 并发运行各用一段
+    install_stop_handlers();
+
+    // 采样快照: 主循环只复制晶格与 O(1) 的能量法 R, 测量与写文件在后台进行, 不阻塞下一个 MCS
+    struct Sample {
+        int mcs, v_pos;
+        double R_energy, step_time, ns_per_hop;
+        vector<int> sites;
+        StructureData sd;
+        DomainStats domains;
+        Probe probe; // 采样时刻的累计插桩计数
+    };
+    AsyncPipeline<Sample> pipeline(snapshot_buffers, analysis_threads,
+        [&](Sample& s, int w) {
+            auto timer = profiler.scope(phase_measure);
+            // FFT 计算 S(k) 与球平均 C(r) (并行)
+            s.sd = sf[w].measure(s.sites);
+            s.domains = labelers[w].measure(s.sites);
+        },
+        [&](Sample& s) {
+            auto timer = profiler.scope(phase_io);
+            // 1. R 写入 output/t_vs_R.txt (符合 Requirement c)
+            r_file << s.mcs << "\t" << s.R_energy << "\n";
+
+            // 2. S(k) 与球平均 C(r) 存储到 output/Sk_t_X.txt, Cr_rad_t_X.txt;
+            //    兼容模式下轴向 C(r) 仍存到 output/Cr_t_X.txt (符合 Requirement c)
+            write_structure(s.sd, "../output", s.mcs);
+            if (axial_Cr_compat) save_C_r(s.sd.C_axial, s.mcs);
+            sk_file << s.mcs << "\t" << s.sd.R_zero << "\t" << s.sd.R_k << "\t" << s.sd.k_mean << "\n";
+
+            // 3. 畴数与畴大小直方图: output/domains.txt, output/domains_t_X.txt
+            write_domains(s.domains, "../output", s.mcs, domain_file);
+
+            // 4. 晶格配置追加为 output/trajectory.bin 中的一帧 (每格点 1 位)
+            trajectory.write_frame(s.mcs, s.sites, s.v_pos);
+            write_instrumentation(instrument_log, s.mcs, start_mcs, s.probe, profiler);
+
+            cout << "MCS: " << s.mcs << " | Time: " << s.step_time << " s | " << s.ns_per_hop << " ns/hop | R: " << s.R_energy << endl;
+        });
     
     auto total_start = chrono::high_resolution_clock::now();
     
-    for (int mcs = 0; mcs <= num_mc; ++mcs) {
+    for (int mcs = start_mcs; mcs <= num_mc; ++mcs) {
         auto step_start = chrono::high_resolution_clock::now();
-        // Monte Carlo 步 (空位交换逻辑)
-        for (int step = 0; step < L * L; ++step) {
-            int dir = uniform_int_distribution<int>(0, 3)(gen);
-            int vx = vacancy_pos / L, vy = vacancy_pos % L;
-            int nx = vx, ny = vy;
-            if (dir == 0) nx++; else if (dir == 1) nx--; else if (dir == 2) ny++; else ny--;
-            int neighbor_idx = get_idx(nx, ny, L);
-
-            double e_old = get_local_energy(lattice, neighbor_idx, L, J);
-            swap(lattice[vacancy_pos], lattice[neighbor_idx]);
-            double e_new = get_local_energy(lattice, vacancy_pos, L, J);
-            double dE = e_new - e_old;
-
-            if (dE <= 0 || uniform_real_distribution<double>(0, 1)(gen) < exp(-dE / T)) {
-                current_energy += dE;
-                vacancy_pos = neighbor_idx;
-            } else {
-                swap(lattice[vacancy_pos], lattice[neighbor_idx]);
-            }
+        // Monte Carlo 步 (空位交换逻辑, 见 vacancy_kernel.h)
+        {
+            auto timer = profiler.scope(phase_kernel);
+            // 有读者时按其请求的间隔分段推进 (仅 Metropolis 核, 轨迹不变), 每段后发布一帧 (见 live_view.h)
+            live.mcs(engine, mcs, [&](long long n) {
+                if (fast_forward && !engine.rejection_free) sweep_fast_forward(engine, n, gen, bulk, probe);
+                else engine.attempts(n, gen, ProbePair<Probe, decltype(coarse)>{probe, coarse});
+            }, !engine.rejection_free && !fast_forward);
         }
 
         auto step_end = chrono::high_resolution_clock::now();
         double step_time = chrono::duration<double>(step_end - step_start).count();
+        double ns_per_hop = step_time * 1e9 / N;
+
+        // 稠密采样: 只用增量维护的量, 代价 O((L/b)^D), 在主循环内同步完成
+        if (is_dense_step(mcs, dense_per_decade)) {
+            auto timer = profiler.scope(phase_measure);
+            auto cd = coarse.measure();
+            dense_file << mcs << "\t" << engine.R_energy() << "\t" << engine.unlike_bonds() << "\t" << cd.sd.R_zero
+                       << "\t" << cd.sd.R_k << "\t" << cd.domains.n_domains << "\n";
+        }
 
         bool is_sample_step = ( (mcs > 0 && (mcs & (mcs - 1)) == 0) || mcs == 0 || mcs == num_mc );
 
-        // 定期记录 (t = 2^n) 符合 Requirement b/c
+        // 定期记录 (t = 2^n) 符合 Requirement b/c; 缓冲区用尽时 acquire 阻塞, 后台落后不会无限堆积
         if (is_sample_step) {
-            // 1. 计算 R 并写入 output/t_vs_R.txt (符合 Requirement c)
-            double R_energy = 2.0 / ((current_energy / (L * L)) / J + 2.0);
-            r_file << mcs << "\t" << R_energy << endl;
-
-            // 2. 计算并存储 C(r) 到 output/Cr_t_X.txt (符合 Requirement c)
-            vector<double> Cr = calculate_C_r(lattice, L);
-            save_C_r(Cr, mcs);
-
-            // 3. 存储晶格配置到 output/lattice_t_X.txt
-            save_lattice(lattice, L, mcs);
-
-            cout << "MCS: " << mcs << " | Time: " << step_time << " s | R: " << R_energy << endl;
+            Sample& sample = pipeline.acquire();
+            sample.mcs = mcs;
+            sample.R_energy = engine.R_energy();
+            sample.step_time = step_time;
+            sample.ns_per_hop = ns_per_hop;
+            sample.sites = engine.sites;
+            sample.v_pos = engine.v_pos;
+            sample.probe = probe;
+            pipeline.submit(sample);
         } else {
             if (mcs % 1000 == 0) {
-                cout << "MCS: " << mcs << " | Time: " << step_time << " s" << endl;
+                cout << "MCS: " << mcs << " | Time: " << step_time << " s | " << ns_per_hop << " ns/hop" << endl;
             }
         }
 
         if (mcs % 1000 == 0) {
-            time_log << mcs << "\t" << step_time << "\n";
+            time_log << mcs << "\t" << step_time << "\t" << ns_per_hop << "\n";
+        }
+
+        // 检查点: 定时或收到 Ctrl-C / SIGTERM 时
+        if (stop_requested || checkpoint_timer.due()) {
+            pipeline.drain(); // 检查点时刻之前的采样全部写完
+            r_file.flush(); time_log.flush(); sk_file.flush(); domain_file.flush(); dense_file.flush(); instrument_log.flush(); trajectory.flush();
+            bool saved = save_checkpoint(checkpoint_file, engine, mcs, gen, outputs);
+            if (stop_requested) {
+                if (!saved) {
+                    cerr << "Stopped at MCS " << mcs << " but the checkpoint could not be written" << endl;
+                    return 1;
+                }
+                cout << "Checkpoint written at MCS " << mcs << ", resume with --resume" << endl;
+                return 0;
+            }
+            if (!saved) cerr << "Warning: checkpoint at MCS " << mcs << " failed, continuing (previous checkpoint kept)" << endl;
         }
     }
     
+    pipeline.drain();
     auto total_end = chrono::high_resolution_clock::now();
     double total_time = chrono::duration<double>(total_end - total_start).count();
     cout << "\nTotal simulation time: " << total_time << " s (" << total_time/60.0 << " min)" << endl;
+    cout << "Average: " << total_time * 1e9 / ((double)(num_mc + 1 - start_mcs) * N) << " ns per attempted hop" << endl;
+    if (bulk.walks > 0) {
+        cout << "Fast-forwarded: " << 100.0 * bulk.walked_attempts / ((double)(num_mc + 1 - start_mcs) * N) << "% of attempts in "
+             << bulk.walks << " walks" << endl;
+    }
     time_log.close();
     r_file.close();
     return 0;
-}
\ No newline at end of file
+}
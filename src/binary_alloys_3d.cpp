@@ -1,12 +1,22 @@
 #include "functions_3d.h"
+#include "structure_factor.h"
+#include "checkpoint.h"
+#include "trajectory.h"
+#include "async_pipeline.h"
+#include "instrumentation.h"
+#include "coarse_grain.h"
+#include "fast_forward.h"
+#include "live_view.h"
 #include <chrono>
+#include <deque>
 #include <filesystem>
 #include <math.h>
 
 using namespace std;
 namespace fs = std::filesystem;
 
-int main() {
+// 用法: ./binary_alloys_3d [--resume]
+int main(int argc, char** argv) {
     
     // 1. 参数设置
     const int L = 64; // 3D 计算量大，L建议先设小一点
@@ -15,81 +25,182 @@ int main() {
     const double T = Tc_3d / 2.0;
     const double J = 1.0;
     const int num_mc = pow(2,20);
+    const bool axial_Cr_compat = true; // 兼容模式: 继续输出轴向 Cr_t_X.txt
+    const double checkpoint_interval = 600.0; // 每 10 分钟写一次检查点
+    const string checkpoint_file = "../output_3d/checkpoint.bin";
+    const string trajectory_file = "../output_3d/trajectory.bin"; // 晶格快照 (二进制, 见 trajectory.h)
+    const bool compress_frames = false; // 帧的无损游程压缩; 关闭时 Python 端可直接 memmap
+    const bool instrument = false; // 热路径插桩: 按 de 的接受率、空位 MSD、分阶段计时与硬件计数器 (见 instrumentation.h)
+    const string instrument_file = "../output_3d/instrumentation.jsonl"; // 与 t_vs_R.txt 同目录, 每个采样时刻一行
+    const int coarse_block = 4; // 粗粒化块边长 b: 块自旋和随每次跳跃增量更新 (见 coarse_grain.h)
+    const int dense_per_decade = 20; // 稠密采样 t_vs_R_dense.txt: 每十倍 MCS 的点数 (0 为每个 MCS)
+    const bool morton_order = true; // 格点按 Morton (Z 序) 存储, 沿 x 的跳跃不再跨 L^2 个格点 (见 lattice.h); 测量与快照按行优先重排
+    const bool fast_forward = false; // 纯畴内空位行走快进 (见 fast_forward.h): 3D 在 Tc/2 下畴内约 0.5% 热激发的少数原子, 纯区域罕见, 打开反而慢
+    const bool live_view = true; // 共享内存实时视图 /dev/shm/vmd_live_3d_<pid> (见 live_view.h, 读取端 python live_view.py vmd_live_3d); 无读者时每个 MCS 只多一次时间比较
+    const int analysis_threads = 2, snapshot_buffers = 3; // 后台测量线程数 / 快照缓冲区数 (见 async_pipeline.h)
+    const vector<string> outputs = {"../output_3d/t_vs_R.txt", "../output_3d/time_log.txt", "../output_3d/t_vs_R_sk.txt", trajectory_file, "../output_3d/domains.txt", instrument_file, "../output_3d/t_vs_R_dense.txt"};
+    const bool resume = argc > 1 && string(argv[1]) == "--resume";
 
     // 2. 初始化
-    mt19937 gen(chrono::steady_clock::now().time_since_epoch().count());
-    vector<int> lattice;
-    int v_pos;
-    initialize_lattice_3d(lattice, L, v_pos, gen);
-    
-    double current_energy = get_total_energy_3d(lattice, L, J);
-    ofstream r_file("../output_3d/t_vs_R.txt");
-    ofstream time_log("../output_3d/time_log.txt");
+    const uint64_t seed = chrono::steady_clock::now().time_since_epoch().count(); // 记录在轨迹文件头 (续算时沿用原种子)
+    Rng gen(seed); // xoshiro256** 批量生成 (见 rng.h)
+    // 格点存储: vector<int> 在 L <= 128 时最快; L >= 256 改用 PackedSites (每格点 1 位)
+    using Storage = vector<int>;
+    // 跳跃核每次尝试: L = 64 时 Morton 快约 4%, L = 128 / 256 / 512 时快 1.2 / 1.35 / 1.35 倍 (benchmark 的 row_major / morton)
+    using Order = conditional_t<morton_order, Morton, RowMajor>;
+    VacancyEngine<3, L, Storage, HyperCubic<3>, Order> engine(L, T, J); // 编译期 L, 6 个邻居循环完全展开
+    int start_mcs = 0;
+    if (resume) {
+        int last_mcs;
+        if (!load_checkpoint(checkpoint_file, engine, last_mcs, gen, outputs)) return 1;
+        start_mcs = last_mcs + 1;
+        cout << "Resumed from MCS " << last_mcs << endl;
+    } else {
+        engine.initialize(gen);
+    }
+    engine.rejection_free = T < 0.35 * Tc_3d; // 低温淬火 (0.2 Tc) 用无拒绝 BKL 核, 动力学相同
+    // 不插桩时 Probe 为 NullProbe, 内核中的探针调用在编译期消除
+    using Probe = conditional_t<instrument, HopProbe<3>, NullProbe>;
+    Probe probe(engine.table);
+    PhaseProfiler profiler(instrument);
+    // 块自旋和作为第二个探针挂在内核上; 检查点只存晶格, 续算后由构型重建
+    CoarseGrid<decltype(engine.lat)> coarse(engine.lat, coarse_block);
+    coarse.rebuild(engine.lat, engine.sites);
+    // 快进时块和由快进核经 bulk 维护, coarse 不再作为探针传入
+    BulkWalk<decltype(engine.lat)> bulk(engine.lat, coarse);
+    // 测量模块作用于行优先的快照 (与存储顺序无关)
+    using MeasureLattice = typename decltype(engine.lat)::row_major_type;
+    const MeasureLattice measure_lat(L);
+    // FFT 测量模块, O(N log N); 每个后台线程一份工作区
+    vector<StructureFactor<MeasureLattice>> sf(analysis_threads, StructureFactor<MeasureLattice>(measure_lat));
+    // 畴标记 (并行 union-find, 见 domains.h); 每个后台线程一个, 硬件线程在它们之间平分
+    deque<DomainLabeler<MeasureLattice>> labelers;
+    for (int w = 0; w < analysis_threads; ++w) labelers.emplace_back(measure_lat, max(1, (int)thread::hardware_concurrency() / analysis_threads));
 
-    auto total_start = chrono::high_resolution_clock::now();
+    // 续算时以追加方式打开 (load_checkpoint 已截断到检查点时刻的长度)
+    auto mode = resume ? ios::app : ios::out;
+    ofstream r_file(outputs[0], mode);
+    ofstream time_log(outputs[1], mode);
+    ofstream sk_file(outputs[2], mode); // mcs, 球平均 C(r) 零点, 2π/k̄, k̄
+    ofstream domain_file(outputs[4], mode); // mcs, 畴数, 平均大小, 加权平均大小, 最大畴, 贯穿畴数
+    ofstream dense_file(outputs[6], mode); // mcs, 能量法 R, 异类键数, 粗粒化 C(r) 零点, 粗粒化 2π/k̄, 粗粒化畴数
+    ofstream instrument_log;
+    if (instrument) instrument_log.open(instrument_file, mode);
+    TrajectoryWriter trajectory(trajectory_file, 3, L, HyperCubic<3>::name(), T, J, seed, compress_frames, resume);
+    if (!trajectory.ok()) {
+        cerr << "Cannot " << (resume ? "append to" : "create") << " trajectory file " << trajectory_file << endl;
+        return 1;
+    }
+    CheckpointTimer checkpoint_timer(checkpoint_interval);
+    LiveView live(live_view, "/vmd_live_3d_" + to_string(getpid()), engine.lat, T, J); // 带进程号, 并发运行各用一段
+    install_stop_handlers();
 
-    // 3. 模拟循环
-    for (int mcs = 0; mcs <= num_mc; ++mcs) {
-        auto step_start = chrono::high_resolution_clock::now();
-        for (int step = 0; step < N; ++step) {
-            int dir = uniform_int_distribution<int>(0, 5)(gen); // 6个方向
-            int vx = v_pos / (L * L);
-            int vy = (v_pos / L) % L;
-            int vz = v_pos % L;
+    // 采样快照: 主循环只复制晶格 (按行优先顺序, Storage 不变) 与 O(1) 的能量法 R, 测量与写文件在后台进行
+    struct Sample {
+        int mcs, v_pos;
+        double R_energy, step_time, ns_per_hop;
+        Storage sites;
+        StructureData sd;
+        DomainStats domains;
+        Probe probe; // 采样时刻的累计插桩计数
+    };
+    AsyncPipeline<Sample> pipeline(snapshot_buffers, analysis_threads,
+        [&](Sample& s, int w) {
+            auto timer = profiler.scope(phase_measure);
+            s.sd = sf[w].measure(s.sites);
+            s.domains = labelers[w].measure(s.sites);
+        },
+        [&](Sample& s) {
+            auto timer = profiler.scope(phase_io);
+            r_file << s.mcs << "\t" << s.R_energy << "\n";
+            write_structure(s.sd, "../output_3d", s.mcs);
+            if (axial_Cr_compat) write_C_r(s.sd.C_axial, "../output_3d/Cr_t_" + to_string(s.mcs) + ".txt");
+            sk_file << s.mcs << "\t" << s.sd.R_zero << "\t" << s.sd.R_k << "\t" << s.sd.k_mean << "\n";
 
-            int nx = vx, ny = vy, nz = vz;
-            if (dir == 0) nx++; else if (dir == 1) nx--;
-            else if (dir == 2) ny++; else if (dir == 3) ny--;
-            else if (dir == 4) nz++; else nz--;
+            write_domains(s.domains, "../output_3d", s.mcs, domain_file);
 
-            int n_idx = get_idx_3d(nx, ny, nz, L);
+            trajectory.write_frame(s.mcs, s.sites, s.v_pos);
+            write_instrumentation(instrument_log, s.mcs, start_mcs, s.probe, profiler);
+            cout << "3D Lattice saved for t = " << s.mcs << endl;
+            cout << "MCS: " << s.mcs << " | Time: " << s.step_time << " s | " << s.ns_per_hop << " ns/hop | R: " << s.R_energy << endl;
+        });
 
-            double e_old = get_local_energy_3d(lattice, n_idx, L, J);
-            swap(lattice[v_pos], lattice[n_idx]);
-            double e_new = get_local_energy_3d(lattice, v_pos, L, J);
-            double dE = e_new - e_old;
+    auto total_start = chrono::high_resolution_clock::now();
 
-            if (dE <= 0 || uniform_real_distribution<double>(0,1)(gen) < exp(-dE/T)) {
-                current_energy += dE;
-                v_pos = n_idx;
-            } else {
-                swap(lattice[v_pos], lattice[n_idx]);
-            }
+    // 3. 模拟循环
+    for (int mcs = start_mcs; mcs <= num_mc; ++mcs) {
+        auto step_start = chrono::high_resolution_clock::now();
+        {
+            auto timer = profiler.scope(phase_kernel);
+            // 有读者时按其请求的间隔分段推进 (仅 Metropolis 核, 轨迹不变), 每段后发布一帧 (见 live_view.h)
+            live.mcs(engine, mcs, [&](long long n) {
+                if (fast_forward && !engine.rejection_free) sweep_fast_forward(engine, n, gen, bulk, probe); // 6个方向, 见 vacancy_kernel.h
+                else engine.attempts(n, gen, ProbePair<Probe, decltype(coarse)>{probe, coarse});
+            }, !engine.rejection_free && !fast_forward);
         }
 
         auto step_end = chrono::high_resolution_clock::now();
         double step_time = chrono::duration<double>(step_end - step_start).count();
+        double ns_per_hop = step_time * 1e9 / N;
+
+        // 稠密采样: 只用增量维护的量, 代价 O((L/b)^D), 在主循环内同步完成
+        if (is_dense_step(mcs, dense_per_decade)) {
+            auto timer = profiler.scope(phase_measure);
+            auto cd = coarse.measure();
+            dense_file << mcs << "\t" << engine.R_energy() << "\t" << engine.unlike_bonds() << "\t" << cd.sd.R_zero
+                       << "\t" << cd.sd.R_k << "\t" << cd.domains.n_domains << "\n";
+        }
 
         bool is_sample_step = ( (mcs > 0 && (mcs & (mcs - 1)) == 0) || mcs == 0 || mcs == num_mc );
 
-        // 4. 定期采样 (t = 2^n)
+        // 4. 定期采样 (t = 2^n): 交给后台流水线; 缓冲区用尽时 acquire 阻塞 (反压)
         if (is_sample_step) {
-            double R = 3.0 / ((current_energy / N) / J + 3.0);
-            r_file << mcs << "\t" << R << endl;
-            
-            vector<double> Cr = calculate_C_r_3d(lattice, L);
-            string c_name = "../output_3d/Cr_t_" + to_string(mcs) + ".txt";
-            ofstream c_out(c_name);
-            for(size_t r=0; r<Cr.size(); ++r) c_out << r << "\t" << Cr[r] << "\n";
-
-            save_lattice_3d(lattice, L, mcs);
-            
-            cout << "MCS: " << mcs << " | Time: " << step_time << " s | R: " << R << endl;
+            Sample& sample = pipeline.acquire();
+            sample.mcs = mcs;
+            sample.R_energy = engine.R_energy();
+            sample.step_time = step_time;
+            sample.ns_per_hop = ns_per_hop;
+            to_row_major(engine.lat, engine.sites, sample.sites);
+            sample.v_pos = engine.lat.row_major_index(engine.v_pos);
+            sample.probe = probe;
+            pipeline.submit(sample);
         } else {
             if (mcs % 1000 == 0) {
-                cout << "MCS: " << mcs << " | Time: " << step_time << " s" << endl;
+                cout << "MCS: " << mcs << " | Time: " << step_time << " s | " << ns_per_hop << " ns/hop" << endl;
             }
         }
 
         if (mcs % 1000 == 0) {
-            time_log << mcs << "\t" << step_time << "\n";
+            time_log << mcs << "\t" << step_time << "\t" << ns_per_hop << "\n";
+        }
+
+        // 检查点: 定时或收到 Ctrl-C / SIGTERM 时
+        if (stop_requested || checkpoint_timer.due()) {
+            pipeline.drain(); // 检查点时刻之前的采样全部写完
+            r_file.flush(); time_log.flush(); sk_file.flush(); domain_file.flush(); dense_file.flush(); instrument_log.flush(); trajectory.flush();
+            bool saved = save_checkpoint(checkpoint_file, engine, mcs, gen, outputs);
+            if (stop_requested) {
+                if (!saved) {
+                    cerr << "Stopped at MCS " << mcs << " but the checkpoint could not be written" << endl;
+                    return 1;
+                }
+                cout << "Checkpoint written at MCS " << mcs << ", resume with --resume" << endl;
+                return 0;
+            }
+            if (!saved) cerr << "Warning: checkpoint at MCS " << mcs << " failed, continuing (previous checkpoint kept)" << endl;
         }
     }
     
+    pipeline.drain();
     auto total_end = chrono::high_resolution_clock::now();
     double total_time = chrono::duration<double>(total_end - total_start).count();
     cout << "\nTotal simulation time: " << total_time << " s (" << total_time/60.0 << " min)" << endl;
+    cout << "Average: " << total_time * 1e9 / ((double)(num_mc + 1 - start_mcs) * N) << " ns per attempted hop" << endl;
+    if (bulk.walks > 0) {
+        cout << "Fast-forwarded: " << 100.0 * bulk.walked_attempts / ((double)(num_mc + 1 - start_mcs) * N) << "% of attempts in "
+             << bulk.walks << " walks" << endl;
+    }
     time_log.close();
     r_file.close();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,92 @@
+#include "parallel_engine.h"
+#include "structure_factor.h"
+#include "config.h"
+#include <chrono>
+#include <filesystem>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// 大晶格并行模式: 稀疏多空位 + 棋盘式区域分解 (见 parallel_engine.h)
+// 时间 t 以 "全部空位共 N 次尝试" 为一个 MCS, 与单空位结果可直接比较
+// 用法: ./binary_alloys_parallel [配置文件 ...] [--key=value ...]   键:
+//   D = 2 | 3   L = 1024 (2D) / 256 (3D)   num_mc = 65536   T_over_Tc = 0.5   J = 1
+//   blocks_per_axis = 16 (L 须为其整数倍, 子区域边长 >= 2)   vacancy_spacing = 4096 (每多少格点一个空位)
+//   seed = 0 (0 = 按时钟)   output = ../output/parallel (3D: ../output_3d/parallel)
+// 没有检查点 / 续算; 需要中断续算时用单空位驱动程序
+struct ParallelOptions {
+    int L, num_mc, blocks_per_axis, vacancy_spacing;
+    double T, J;
+    uint64_t seed;
+    string dir;
+};
+
+template <int D, int CL>
+int run(const ParallelOptions& opt) {
+    const int L = opt.L, num_mc = opt.num_mc;
+    long long N = 1;
+    for (int a = 0; a < D; ++a) N *= L;
+    const int n_vacancies = (int)max(1LL, N / opt.vacancy_spacing); // 默认空位浓度 ~2.4e-4
+    fs::create_directories(opt.dir);
+    const string& dir = opt.dir;
+
+    WorkerPool pool; // 全部硬件线程
+    ParallelVacancyEngine<D, CL> engine(L, opt.T, opt.J, n_vacancies, opt.blocks_per_axis, opt.seed);
+    engine.initialize();
+    StructureFactor<decltype(engine.lat)> sf(engine.lat);
+
+    ofstream r_file(dir + "/t_vs_R.txt");
+    r_file << "# seed = " << opt.seed << ", rng = " << rng_name << ", vacancies = " << n_vacancies << "\n";
+    ofstream time_log(dir + "/time_log.txt");
+    cout << "Parallel vacancy dynamics: L=" << L << " D=" << D << " vacancies=" << n_vacancies
+         << " threads=" << pool.size() << " seed=" << opt.seed << " rng=" << rng_name << endl;
+
+    auto total_start = chrono::high_resolution_clock::now();
+    for (int mcs = 0; mcs <= num_mc; ++mcs) {
+        auto step_start = chrono::high_resolution_clock::now();
+        engine.mcs(pool);
+        double step_time = chrono::duration<double>(chrono::high_resolution_clock::now() - step_start).count();
+        double ns_per_hop = step_time * 1e9 / N;
+
+        if ((mcs > 0 && (mcs & (mcs - 1)) == 0) || mcs == 0 || mcs == num_mc) {
+            double R = engine.R_energy();
+            StructureData sd = sf.measure(engine.sites, n_vacancies);
+            r_file << mcs << "\t" << R << "\t" << sd.R_zero << "\t" << sd.R_k << endl;
+            write_C_r(sd.C_axial, dir + "/Cr_t_" + to_string(mcs) + ".txt");
+            write_structure(sd, dir, mcs);
+            cout << "MCS: " << mcs << " | Time: " << step_time << " s | " << ns_per_hop << " ns/hop | R: " << R << endl;
+        }
+        if (mcs % 1000 == 0) time_log << mcs << "\t" << step_time << "\t" << ns_per_hop << "\n";
+    }
+    double total_time = chrono::duration<double>(chrono::high_resolution_clock::now() - total_start).count();
+    cout << "\nTotal simulation time: " << total_time << " s (" << total_time/60.0 << " min)" << endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Config cfg;
+    if (!cfg.parse_args(argc, argv)) return 1;
+    const int D = (int)cfg.get("D", 2LL);
+    if (D != 2 && D != 3) { cerr << "D 只能为 2 或 3: " << D << endl; return 1; }
+
+    ParallelOptions opt;
+    opt.L = (int)cfg.get("L", D == 2 ? 1024LL : 256LL);
+    opt.num_mc = (int)cfg.get("num_mc", 65536LL);
+    opt.blocks_per_axis = (int)cfg.get("blocks_per_axis", 16LL); // 子区域边长 L/16
+    opt.vacancy_spacing = (int)cfg.get("vacancy_spacing", 4096LL);
+    opt.T = cfg.get("T_over_Tc", 0.5) * critical_temperature(default_geometry(D), D);
+    opt.J = cfg.get("J", 1.0);
+    opt.seed = (uint64_t)cfg.get("seed", 0LL);
+    if (opt.seed == 0) opt.seed = chrono::steady_clock::now().time_since_epoch().count();
+    opt.dir = cfg.get("output", D == 2 ? "../output/parallel" : "../output_3d/parallel");
+
+    const int nb = opt.blocks_per_axis;
+    if (nb < 2 || nb % 2 != 0 || opt.L % nb != 0 || opt.L / nb < 2 || opt.vacancy_spacing < 1) {
+        cerr << "blocks_per_axis 须为偶数且整除 L, 子区域边长 >= 2 (L = " << opt.L << ", blocks_per_axis = " << nb << ")" << endl;
+        return 1;
+    }
+
+    // 默认边长在编译期实例化 (位掩码边界), 其余 L 走运行期版本
+    if (D == 2) return opt.L == 1024 ? run<2, 1024>(opt) : run<2, 0>(opt);
+    return opt.L == 256 ? run<3, 256>(opt) : run<3, 0>(opt);
+}
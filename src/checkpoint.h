@@ -0,0 +1,163 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include "vacancy_engine.h"
+
+using namespace std;
+
+// 断点续算 (checkpoint / restart)
+// 二进制检查点包含完整的引擎状态: 晶格 (每格点 1 位)、空位位置、整数能量、mcs、
+// 序列化的随机数发生器状态, 以及各输出文件在检查点时刻的长度.
+// --resume 时把输出文件截断到记录的长度再以追加方式继续, 续算结果与不中断运行逐位相同.
+// 写入先写临时文件再 rename, 中途被杀也不会留下损坏的检查点.
+
+// Ctrl-C / SIGTERM 只设置标志, 主循环在当前 MCS 结束后写检查点并退出
+inline volatile sig_atomic_t stop_requested = 0;
+inline void request_stop(int) { stop_requested = 1; }
+inline void install_stop_handlers() {
+    signal(SIGINT, request_stop);
+    signal(SIGTERM, request_stop);
+}
+
+// 按墙钟时间间隔触发检查点; 检查点的代价是 O(N/64) 次字写入, 远小于一个 MCS 的 N 次跳跃
+class CheckpointTimer {
+public:
+    explicit CheckpointTimer(double interval_s) : interval(interval_s), last(chrono::steady_clock::now()) {}
+    bool due() {
+        auto now = chrono::steady_clock::now();
+        if (chrono::duration<double>(now - last).count() < interval) return false;
+        last = now;
+        return true;
+    }
+private:
+    double interval;
+    chrono::steady_clock::time_point last;
+};
+
+const char checkpoint_magic[8] = {'V', 'M', 'D', 'C', 'K', 'P', 'T', '2'}; // 2: 随机数状态为 BatchedRng
+// 读取时长度字段的上限: 随机数状态为文本 (约 350 字节), 输出文件数为驱动程序的 outputs 个数
+const uint64_t checkpoint_max_rng_state = 4096;
+const uint32_t checkpoint_max_outputs = 256;
+
+template <class T>
+inline void put(ostream& out, const T& v) { out.write(reinterpret_cast<const char*>(&v), sizeof(T)); }
+template <class T>
+inline void get(istream& in, T& v) { in.read(reinterpret_cast<char*>(&v), sizeof(T)); }
+
+// 返回是否成功; 失败时 (磁盘满、无权限等) 旧检查点保持不变
+template <class Engine, class URBG>
+bool save_checkpoint(const string& path, const Engine& e, int mcs, const URBG& gen,
+                     const vector<string>& outputs) {
+    string tmp = path + ".tmp";
+    error_code ec;
+    {
+        ofstream out(tmp, ios::binary | ios::trunc);
+        out.write(checkpoint_magic, 8);
+        put(out, (int32_t)Engine::lattice_type::dim);
+        put(out, (int32_t)e.size());
+        put(out, e.T);
+        put(out, e.J);
+        put(out, (int32_t)mcs);
+        put(out, (int32_t)e.lat.row_major_index(e.v_pos));
+        put(out, (int64_t)e.energy);
+
+        ostringstream rng;
+        rng << gen;
+        string state = rng.str();
+        put(out, (uint64_t)state.size());
+        out.write(state.data(), state.size());
+
+        put(out, (uint32_t)outputs.size());
+        for (const string& f : outputs) {
+            uint64_t len = filesystem::exists(f, ec) ? filesystem::file_size(f, ec) : 0;
+            if (ec) { cerr << "检查点写入失败: 无法读取 " << f << " 的长度" << endl; return false; }
+            put(out, len);
+        }
+
+        // 构型总按行优先顺序存储, 与引擎的格点顺序 (lattice.h) 无关
+        vector<uint64_t> words;
+        if constexpr (Engine::lattice_type::row_major) {
+            words = pack_sites(e.sites, e.sites_count());
+        } else {
+            auto rm = e.sites;
+            to_row_major(e.lat, e.sites, rm);
+            words = pack_sites(rm, e.sites_count());
+        }
+        put(out, (uint64_t)words.size());
+        out.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t));
+        out.close(); // 缓冲区中的数据在关闭时才真正写出, 磁盘满在这里暴露
+        if (!out) { cerr << "检查点写入失败: " << tmp << endl; return false; }
+    }
+    filesystem::rename(tmp, path, ec);
+    if (ec) { cerr << "检查点写入失败: " << tmp << " -> " << path << ": " << ec.message() << endl; return false; }
+    return true;
+}
+
+// 成功时恢复引擎、mcs 与随机数状态, 并把输出文件截断到检查点时刻的长度
+template <class Engine, class URBG>
+bool load_checkpoint(const string& path, Engine& e, int& mcs, URBG& gen, const vector<string>& outputs) {
+    ifstream in(path, ios::binary);
+    if (!in.is_open()) { cerr << "未找到检查点: " << path << endl; return false; }
+    char magic[8];
+    in.read(magic, 8);
+    int32_t dim, L, m, v;
+    double T, J;
+    int64_t energy;
+    get(in, dim); get(in, L); get(in, T); get(in, J); get(in, m); get(in, v); get(in, energy);
+    if (!in || memcmp(magic, checkpoint_magic, 8) != 0 || dim != Engine::lattice_type::dim
+        || L != e.size() || T != e.T || J != e.J) {
+        cerr << "检查点与当前参数不匹配: " << path << endl;
+        return false;
+    }
+
+    // 长度字段先检查流状态与上限再分配, 截断或损坏的文件只报告不完整
+    auto incomplete = [&]() { cerr << "检查点文件不完整: " << path << endl; return false; };
+    if (v < 0 || v >= e.sites_count()) return incomplete();
+    uint64_t n;
+    get(in, n);
+    if (!in || n > checkpoint_max_rng_state) return incomplete();
+    string state(n, '\0');
+    in.read(&state[0], n);
+    if (!in) return incomplete();
+    istringstream rng(state);
+    if (!(rng >> gen)) return incomplete();
+
+    uint32_t n_out;
+    get(in, n_out);
+    if (!in || n_out > checkpoint_max_outputs) return incomplete();
+    vector<uint64_t> lengths(n_out);
+    for (auto& len : lengths) get(in, len);
+
+    get(in, n);
+    if (!in || n != ((uint64_t)e.sites_count() + 63) / 64) return incomplete();
+    vector<uint64_t> words(n);
+    in.read(reinterpret_cast<char*>(words.data()), n * sizeof(uint64_t));
+    if (!in) return incomplete();
+
+    unpack_sites(words, e.sites_count(), v, e.sites);
+    if constexpr (!Engine::lattice_type::row_major) {
+        auto rm = e.sites;
+        from_row_major(e.lat, rm, e.sites);
+        v = e.lat.index(typename Engine::lattice_type::row_major_type(e.size()).coords(v));
+    }
+    e.v_pos = v;
+    e.vc = e.lat.coords(v);
+    e.energy = energy;
+    mcs = m;
+    for (size_t i = 0; i < outputs.size() && i < lengths.size(); ++i) {
+        if (filesystem::exists(outputs[i])) filesystem::resize_file(outputs[i], lengths[i]);
+    }
+    return true;
+}
+
+#endif
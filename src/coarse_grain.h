@@ -0,0 +1,123 @@
+#ifndef COARSE_GRAIN_H
+#define COARSE_GRAIN_H
+
+#include <vector>
+#include <cmath>
+#include <cassert>
+#include "structure_factor.h"
+#include "domains.h"
+
+using namespace std;
+
+// 增量维护的粗粒化观测量: 每个 b^D 块 (沿每个原胞轴 b 个格点) 的自旋和 B (空位计 0).
+// 作为探针挂在跳跃核上 (vacancy_kernel.h 的 moved), 每次被接受的跳跃只改两个块, O(1);
+// 连同引擎里已是增量的 energy / unlike_bonds(), 测量代价与晶格点数 N 无关, 可按任意频率采样:
+//   measure().sd      块场的 S(k) 与 C(r), 已换算回原晶格的单位 (k / b, r * b, S / b^D);
+//                     块平均相当于低通滤波: C(r) 零点在 R >> b 后与全晶格测量一致; R_k 截掉了 k > π/b 的
+//                     Porod 尾, 系统性偏大 (2D, b = 4 约 15%), 但比值趋于常数, 不影响指数拟合
+//   measure().domains 粗粒化畴图 sign(B) 的畴统计 (大小以块为单位, B = 0 的块不属于任何畴)
+// 代价 O((L/b)^D log(L/b)); b 须是 2 的幂且整除 L
+template <class Lat>
+class CoarseGrid {
+public:
+    static constexpr bool enabled = true;
+    static constexpr int D = Lat::dim;
+    using coarse_lattice = Lattice<D, 0, typename Lat::geometry>;
+    using Coord = typename Lat::Coord;
+
+    struct Data {
+        StructureData sd;
+        DomainStats domains;
+    };
+
+    CoarseGrid(const Lat& lat, int b_)
+        : b(b_), shift(log2_int(b_)), clat(lat.size() / b_), block(clat.sites(), 0), signs(clat.sites(), 0),
+          sf(clat), labeler(clat, 1) {
+        assert(is_pow2(b) && lat.size() % b == 0);
+        for (int a = 0; a < D; ++a) cstride[a] = clat.stride(a);
+    }
+
+    int block_size() const { return b; }
+    const coarse_lattice& lattice() const { return clat; }
+    const vector<int>& sums() const { return block; }
+    int vacancy_cell() const { return vac_cell; }
+
+    // 坐标 c 所在块的粗晶格索引
+    inline int cell(const Coord& c) const {
+        int k = 0;
+        for (int a = 0; a < D; ++a) k += (c[a] >> shift) * cstride[a];
+        return k;
+    }
+
+    // 由完整构型重建 (初始化 / 续算后调用一次), O(N); 同时记下空位所在的块
+    template <class Sites>
+    void rebuild(const Lat& lat, const Sites& sites) {
+        fill(block.begin(), block.end(), 0);
+        for_each_site(lat, [&](int i, const Coord& c) {
+            block[cell(c)] += sites[i];
+            if (sites[i] == 0) vac_cell = cell(c);
+        });
+    }
+
+    inline void hop(int, bool, int) {}
+    inline void skipped(long long) {}
+    template <class Disp>
+    inline void walked(long long, const Disp&) {}
+    // 单空位: 跳跃后的新空位就是 from, 它的块号留作下一次的 to, 每次只算一个块号
+    inline void moved(const Coord& from, const Coord&, int s) {
+        int f = cell(from);
+        block[f] -= s;
+        block[vac_cell] += s;
+        vac_cell = f;
+    }
+
+    // 粗粒化畴图: sign(B) ∈ {-1, 0, +1}, 按粗晶格索引
+    const vector<int>& domain_map() {
+        for (size_t k = 0; k < block.size(); ++k) signs[k] = (block[k] > 0) - (block[k] < 0);
+        return signs;
+    }
+
+    Data measure() {
+        Data out;
+        out.sd = sf.measure(block, 0);
+        rescale(out.sd);
+        out.domains = labeler.measure(domain_map());
+        return out;
+    }
+
+private:
+    int b, shift;
+    int vac_cell = 0;
+    coarse_lattice clat;
+    int cstride[D];
+    vector<int> block, signs;
+    StructureFactor<coarse_lattice> sf;
+    DomainLabeler<coarse_lattice> labeler;
+
+    // 块场的 C(r) 按 <B^2> 归一化 (StructureFactor 按 ±1 自旋归一), 长度与波矢换回原晶格单位
+    void rescale(StructureData& sd) const {
+        double var = 0.0;
+        for (int B : block) var += (double)B * B;
+        var /= block.size();
+        if (var > 0) {
+            for (size_t r = 1; r < sd.C_radial.size(); ++r) sd.C_radial[r] /= var;
+            for (size_t r = 1; r < sd.C_axial.size(); ++r) sd.C_axial[r] /= var;
+        }
+        double volume = pow((double)b, D);
+        for (double& r : sd.r_radial) r *= b;
+        for (double& k : sd.k_shell) k /= b;
+        for (double& s : sd.S_k) s /= volume;
+        sd.R_zero *= b;
+        sd.k_mean /= b;
+        sd.R_k *= b;
+    }
+};
+
+// 稠密采样时刻: 以 per_decade 个点每十倍 MCS 的几何间隔 (每个对数区间 [10^(k/n), 10^((k+1)/n)) 的第一个整数 MCS),
+// 早期区间短于 1 MCS 时即每个 MCS; per_decade <= 0 时每个 MCS. 只依赖 mcs, 续算后时刻不变
+inline bool is_dense_step(int mcs, int per_decade) {
+    if (per_decade <= 0 || mcs <= 1) return true;
+    return floor(per_decade * log10((double)mcs)) > floor(per_decade * log10(mcs - 1.0));
+}
+
+#endif
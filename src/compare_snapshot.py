@@ -1,28 +1,25 @@
 import numpy as np
 import matplotlib.pyplot as plt
-import glob
-import re
+from trajectory import Trajectory
 
 def plot_snapshot_comparison(target_t=None):
-    # 如果不指定时间，默认找 output 文件夹里最大的那个时间点
+    try:
+        traj = Trajectory('../output/trajectory.bin')
+    except IOError:
+        print("未找到晶格文件。")
+        return
+    # 如果不指定时间，默认取轨迹中最大的那个时间点
     if target_t is None:
-        files = glob.glob('../output/lattice_t_*.txt')
-        if not files:
-            print("未找到晶格文件。")
-            return
-        # 提取文件名中的数字并找到最大值
-        times = [int(re.search(r't_(\d+)', f).group(1)) for f in files]
-        target_t = max(times)
-
-    # 构建文件名
-    file_vac = f'../output/lattice_t_{target_t}.txt'
+        target_t = max(traj.times)
+
+    # Kawasaki 基线仍为文本快照
     file_kaw = f'../output/lattice_kawasaki_t_{target_t}.txt'
 
     try:
         # 读取数据
-        lat_vac = np.loadtxt(file_vac)
+        lat_vac = traj.at(target_t)
         lat_kaw = np.loadtxt(file_kaw)
-    except IOError:
+    except (IOError, ValueError):
         print(f"错误：找不到时刻 t={target_t} 的数据文件。请确保两个模拟都运行到了该时刻。")
         return
 
@@ -0,0 +1,190 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <map>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+#include "rng.h"
+#include "geometry.h"
+
+using namespace std;
+
+// 运行期参数: "key = value" 配置文件 (# 开头为注释) 与命令行 --key=value, 后者覆盖前者.
+// 值中用逗号分隔多个取值时展开为扫描网格, 见 expand_jobs
+class Config {
+public:
+    map<string, string> values;
+
+    bool load_file(const string& path) {
+        ifstream in(path);
+        if (!in.is_open()) { cerr << "无法打开配置文件: " << path << endl; return false; }
+        string line;
+        while (getline(in, line)) {
+            line = line.substr(0, line.find('#'));
+            size_t eq = line.find('=');
+            if (eq == string::npos) continue;
+            set(trim(line.substr(0, eq)), trim(line.substr(eq + 1)));
+        }
+        return true;
+    }
+
+    // 参数: 不含 '=' 的为配置文件路径, 其余为 [--]key=value
+    bool parse_args(int argc, char** argv) {
+        for (int k = 1; k < argc; ++k) {
+            string a = argv[k];
+            size_t eq = a.find('=');
+            if (eq == string::npos) {
+                if (!load_file(a)) return false;
+                continue;
+            }
+            string key = a.substr(0, eq);
+            while (!key.empty() && key[0] == '-') key.erase(0, 1);
+            set(key, a.substr(eq + 1));
+        }
+        return true;
+    }
+
+    void set(const string& key, const string& value) { values[key] = value; }
+    bool has(const string& key) const { return values.count(key) > 0; }
+
+    string get(const string& key, const string& def) const {
+        auto it = values.find(key);
+        return it == values.end() ? def : it->second;
+    }
+    double get(const string& key, double def) const { return has(key) ? number<double>(key, get(key, "")) : def; }
+    long long get(const string& key, long long def) const { return has(key) ? number<long long>(key, get(key, "")) : def; }
+
+    // 数值解析: 整个值都须是数字, 否则报告键与值并以非零状态退出 (与 parse_args 的报错一致)
+    template <class T>
+    static T number(const string& key, const string& text) {
+        size_t used = 0;
+        T value{};
+        try {
+            if constexpr (is_integral_v<T>) value = (T)stoll(text, &used);
+            else value = (T)stod(text, &used);
+        } catch (const exception&) {
+            used = 0;
+        }
+        if (used == 0 || !trim(text.substr(used)).empty()) {
+            cerr << "参数 " << key << " 的值不是有效数字: " << text << endl;
+            exit(1);
+        }
+        return value;
+    }
+
+    vector<string> list(const string& key, const string& def) const {
+        vector<string> out;
+        stringstream ss(get(key, def));
+        for (string item; getline(ss, item, ',');) if (!trim(item).empty()) out.push_back(trim(item));
+        return out;
+    }
+
+private:
+    static string trim(const string& s) {
+        size_t a = s.find_first_not_of(" \t\r\n"), b = s.find_last_not_of(" \t\r\n");
+        return a == string::npos ? "" : s.substr(a, b - a + 1);
+    }
+};
+
+inline string default_geometry(int D) { return D == 2 ? "square" : "cubic"; }
+
+// 一个独立的模拟任务 (网格上的一个点的一个副本)
+struct Job {
+    string dynamics = "vacancy"; // vacancy | kawasaki
+    int D = 2, L = 128;
+    string geometry = "square";  // square | triangular (2D), cubic | bcc | fcc (3D)
+    double T_over_Tc = 0.5, T = 0.0, J = 1.0;
+    int num_mc = 1 << 20;
+    int replica = 0;
+    uint64_t seed = 0;           // 基础种子; 本任务的随机数流为 make_stream(seed, stream)
+    uint32_t stream = 0;
+    string dir;                  // 输出目录
+    bool rejection_free = false; // 空位: BKL 核; Kawasaki: 界面键按 de 分类的无拒绝抽样
+    bool compress_frames = false;
+    double cost = 0.0;           // 估计的相对耗时 (调度用)
+
+    string name() const {
+        ostringstream os;
+        os << dynamics << "_" << D << "d";
+        if (geometry != default_geometry(D)) os << "_" << geometry;
+        os << "_L" << L << "_T" << fixed << setprecision(2) << T_over_Tc << "_r" << replica;
+        return os.str();
+    }
+};
+
+// 展开 (dynamics, D, geometry, L, T/Tc, replicas) 网格. 键:
+//   dynamics = vacancy, kawasaki     D = 2, 3      T_over_Tc = 0.2, 0.5, 0.7 (Tc 按几何取值)
+//   geometry = auto (正方 / 简单立方), square, triangular, cubic, bcc, fcc; 与 D 不符的组合跳过
+//   L = 128 (对所有维度) 或 L_2d = 128, L_3d = 64 (按维度, 优先)
+//   replicas = 1   num_mc = 1048576   J = 1   seed = 0 (0 = 按时钟)
+//   output = ../output/run   rejection_free = auto | on | off   compress_frames = 0 | 1   threads = 0
+//   stream = 0 (第一个任务的随机数流编号; 用某个任务的 config.txt 重跑时即复现该任务)
+// 只有一个任务时直接写入 output, 否则每个任务写入 output/<name>
+inline vector<Job> expand_jobs(const Config& cfg) {
+    uint64_t seed = (uint64_t)cfg.get("seed", 0LL);
+    if (seed == 0) seed = chrono::steady_clock::now().time_since_epoch().count();
+    int replicas = (int)cfg.get("replicas", 1LL);
+    string output = cfg.get("output", "../output/run");
+    string rf = cfg.get("rejection_free", "auto");
+
+    vector<Job> jobs;
+    for (const string& dyn : cfg.list("dynamics", "vacancy")) {
+        for (const string& d : cfg.list("D", "2")) {
+            int D = Config::number<int>("D", d);
+            string L_key = "L_" + d + "d";
+            for (string geo : cfg.list("geometry", "auto")) {
+                if (geo == "auto") geo = default_geometry(D);
+                bool known = valid_geometry(geo, 2) || valid_geometry(geo, 3);
+                if (known && !valid_geometry(geo, D)) continue; // 未知名称留给驱动程序报错
+                for (const string& l : cfg.list(cfg.has(L_key) ? L_key : "L", D == 2 ? "128" : "64")) {
+                    for (const string& t : cfg.list("T_over_Tc", "0.5")) {
+                        for (int r = 0; r < replicas; ++r) {
+                            Job job;
+                            job.dynamics = dyn;
+                            job.D = D;
+                            job.geometry = geo;
+                            job.L = Config::number<int>(cfg.has(L_key) ? L_key : "L", l);
+                            job.T_over_Tc = Config::number<double>("T_over_Tc", t);
+                            job.T = job.T_over_Tc * critical_temperature(geo, D);
+                            job.J = cfg.get("J", 1.0);
+                            job.num_mc = (int)cfg.get("num_mc", (long long)(1 << 20));
+                            job.replica = r;
+                            job.seed = seed;
+                            job.stream = (uint32_t)(cfg.get("stream", 0LL) + jobs.size()); // 复现单个任务时可指定
+                            job.rejection_free = (rf == "on" || (rf == "auto" && job.T_over_Tc < 0.35));
+                            job.compress_frames = cfg.get("compress_frames", 0LL) != 0;
+                            // 每 MCS N 次尝试, 每次 O(z) 邻居访问; Kawasaki 每次算两个邻居和
+                            double N = 1.0;
+                            for (int a = 0; a < D; ++a) N *= job.L;
+                            int z = geo == "fcc" ? 12 : geo == "bcc" ? 8 : geo == "triangular" ? 6 : 2 * D;
+                            job.cost = N * job.num_mc * z * (dyn == "kawasaki" ? 2.0 : 1.0);
+                            jobs.push_back(job);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    for (Job& job : jobs) job.dir = jobs.size() == 1 ? output : output + "/" + job.name();
+    return jobs;
+}
+
+// 任务参数写入输出目录; 该文件本身可作为配置文件重跑这一任务
+inline void write_job_config(const Job& job, const string& path) {
+    ofstream out(path);
+    out << "# " << job.name() << ", T = " << setprecision(10) << job.T << "\n";
+    out << "dynamics = " << job.dynamics << "\nD = " << job.D << "\ngeometry = " << job.geometry << "\nL = " << job.L
+        << "\nT_over_Tc = " << job.T_over_Tc << "\nJ = " << job.J
+        << "\nnum_mc = " << job.num_mc << "\nseed = " << job.seed << "\nstream = " << job.stream
+        << "\nrng = " << rng_name
+        << "\nrejection_free = " << (job.rejection_free ? "on" : "off") << "\n";
+}
+
+#endif
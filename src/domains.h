@@ -0,0 +1,314 @@
+#ifndef DOMAINS_H
+#define DOMAINS_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iomanip>
+#include <atomic>
+#include <algorithm>
+#include "vacancy_engine.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+// 畴统计: 同种原子经最近邻键相连的团簇 (周期边界), 空位不属于任何畴
+struct DomainStats {
+    long long n_domains = 0;
+    long long n_atoms = 0;
+    long long max_size = 0;
+    double mean_size = 0.0;       // Σ s / n_domains
+    double weighted_mean = 0.0;   // Σ s^2 / Σ s, 随机格点所在畴的平均大小
+    int n_spanning = 0;           // 周期边界下贯穿 (沿某一轴绕数非零) 的畴数
+    vector<long long> histogram;  // 第 b 格: 大小在 [2^b, 2^(b+1)) 的畴数
+};
+
+// 并行 Hoshen-Kopelman (union-find) 畴标记, O(N).
+// 晶格沿第 0 轴切成与线程数相同的平板 (各占一段连续索引):
+//   1. 各线程在自己的平板内做 union-find (根取最小索引, 路径减半), 再完全压缩到平板内的根;
+//   2. 单线程合并相邻平板之间 (含周期边界) 的 L^(D-1) 对格点;
+//   3. 并行求出平板根与边界格点的全局根, 再把每个格点指向全局根, 同时统计畴大小;
+//   4. 并行汇总直方图, 并对大小 >= L 的畴检查是否贯穿 (绕数非零, 见 collect).
+// 每个阶段只写本平板的数据, 阶段之间由 WorkerPool::run 同步.
+template <class Lat>
+class DomainLabeler {
+    static_assert(Lat::row_major, "平板分解按行优先排列; Morton 顺序的构型先用 to_row_major 转换");
+public:
+    DomainLabeler(const Lat& lat_, int n_threads = 0)
+        : lat(lat_), pool(n_threads), parent(lat_.sites()), count(lat_.sites()) {
+        int L = lat.size();
+        n_slabs = min(pool.size(), L);
+        slab_x.resize(n_slabs + 1);
+        for (int s = 0; s <= n_slabs; ++s) slab_x[s] = (int)((long long)s * L / n_slabs);
+        roots.resize(n_slabs);
+        fixups.resize(n_slabs);
+        partial.resize(n_slabs);
+    }
+
+    template <class Sites>
+    DomainStats measure(const Sites& sites) {
+        const int plane = lat.stride(0);
+        // 1. 平板内标记
+        pool.run([&](int w) {
+            for (int s = w; s < n_slabs; s += pool.size()) label_slab(sites, s);
+        });
+        // 2. 平板之间的合并 (第 x0 平面与第 x0 - 1 平面)
+        for (int s = 0; s < n_slabs; ++s) {
+            int a = slab_x[s] * plane;
+            if constexpr (Lat::geometry::axial) {
+                int b = (slab_x[s] == 0 ? lat.size() - 1 : slab_x[s] - 1) * plane;
+                for (int k = 0; k < plane; ++k) {
+                    if (parent[a + k] >= 0 && sites[a + k] == sites[b + k]) unite(a + k, b + k);
+                }
+            } else {
+                // 第 0 分量非零的每个键方向各连一次 (-v_k 邻居都在上一个平面)
+                typename Lat::Coord c = lat.coords(a);
+                for (int i = a; i < a + plane; ++i) {
+                    if (parent[i] >= 0) {
+                        for (int k = 0; k < Lat::bond_dirs; ++k) {
+                            if (!Lat::geometry::bond(k, 0)) continue;
+                            int j = lat.neighbor(c, i, 2 * k + 1);
+                            if (sites[i] == sites[j]) unite(i, j);
+                        }
+                    }
+                    for (int d = Lat::dim - 1; d > 0; --d) {
+                        if (++c[d] < lat.size()) break;
+                        c[d] = 0;
+                    }
+                }
+            }
+        }
+        // 3a. 只读地求出平板根与边界格点的全局根
+        pool.run([&](int w) {
+            for (int s = w; s < n_slabs; s += pool.size()) {
+                fixups[s].clear();
+                for (int r : roots[s]) fixups[s].push_back({r, find_root(r)});
+                int lo = slab_x[s] * plane, hi = (slab_x[s + 1] - 1) * plane;
+                for (int k = 0; k < plane; ++k) {
+                    if (parent[lo + k] >= 0) fixups[s].push_back({lo + k, find_root(lo + k)});
+                    if (parent[hi + k] >= 0) fixups[s].push_back({hi + k, find_root(hi + k)});
+                }
+            }
+        });
+        // 3b. 写回全局根, 其余格点经平板根指向全局根; 同时按游程累加畴大小
+        pool.run([&](int w) {
+            for (int s = w; s < n_slabs; s += pool.size()) {
+                for (auto& f : fixups[s]) if (parent[f.first] != f.second) parent[f.first] = f.second;
+                int lo = slab_x[s] * plane, hi = slab_x[s + 1] * plane;
+                int run_root = -1, run = 0;
+                for (int i = lo; i < hi; ++i) {
+                    int p = parent[i];
+                    if (p < 0) continue;
+                    if (p != i) { p = parent[p]; parent[i] = p; }
+                    if (p != run_root) {
+                        if (run) count[run_root].fetch_add(run, memory_order_relaxed);
+                        run_root = p;
+                        run = 0;
+                    }
+                    ++run;
+                }
+                if (run) count[run_root].fetch_add(run, memory_order_relaxed);
+            }
+        });
+        return collect();
+    }
+
+    // 最近一次 measure 后格点 i 所在畴的标签 (全局根索引; 空位为 -1)
+    int label(int i) const { return parent[i]; }
+
+private:
+    struct Partial {
+        long long n = 0, atoms = 0, sumsq = 0, max_size = 0;
+        vector<long long> hist;
+        vector<int> big;           // 大小 >= L 的畴 (贯穿候选)
+    };
+
+    Lat lat;
+    WorkerPool pool;
+    int n_slabs;
+    vector<int> slab_x;
+    vector<int> parent;
+    vector<atomic<int>> count;
+    vector<vector<int>> roots;
+    vector<vector<pair<int, int>>> fixups;
+    vector<Partial> partial;
+    vector<vector<int>> queues;   // 贯穿检查的遍历队列, 每个工作线程一个
+
+    // 贯穿检查中格点相对根的周期像 (各轴回绕次数) 按 wbits 位取模打包进一个 int, 暂存在 count 中
+    static constexpr int wbits = 31 / Lat::dim;
+    static constexpr int wmask = (1 << wbits) - 1;
+
+    int find_root(int i) const {
+        while (parent[i] != i) i = parent[i];
+        return i;
+    }
+
+    int find(int i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]]; // 路径减半
+            i = parent[i];
+        }
+        return i;
+    }
+
+    void unite(int i, int j) {
+        int ri = find(i), rj = find(j);
+        if (ri < rj) parent[rj] = ri;
+        else if (rj < ri) parent[ri] = rj;
+    }
+
+    // 平板内只连接 -v_k 方向的邻居 (超立方时即各轴 -1 方向); 跨出平板 (第 0 分量非零) 的键留给合并阶段
+    template <class Sites>
+    void label_slab(const Sites& sites, int s) {
+        const int L = lat.size();
+        int lo = slab_x[s] * lat.stride(0), hi = slab_x[s + 1] * lat.stride(0);
+        // 周期回绕的 -1 邻居索引更大, 先初始化整个平板
+        for (int i = lo; i < hi; ++i) {
+            count[i].store(0, memory_order_relaxed);
+            parent[i] = sites[i] == 0 ? -1 : i;
+        }
+        typename Lat::Coord c = lat.coords(lo);
+        for (int i = lo; i < hi; ++i) {
+            int si = sites[i];
+            if (si != 0) {
+                // 与同种邻居的根逐个合并; 相邻格点常指向同一父节点, 重复的跳过 find
+                // (i 可能已被更早的周期回绕键连到别处, 所以从 find(i) 开始)
+                int r = find(i), last = -1;
+                for (int k = Lat::bond_dirs - 1; k >= 0; --k) {
+                    if (Lat::geometry::bond(k, 0) && c[0] == slab_x[s]) continue;
+                    int j = lat.neighbor(c, i, 2 * k + 1);
+                    if (sites[j] != si) continue;
+                    int pj = parent[j];
+                    if (pj == last) continue;
+                    last = pj;
+                    int rj = find(pj);
+                    if (rj == r) continue;
+                    if (rj < r) { parent[r] = rj; r = rj; }
+                    else parent[rj] = r;
+                }
+            }
+            for (int a = Lat::dim - 1; a >= 0; --a) {
+                if (++c[a] < L) break;
+                c[a] = 0;
+            }
+        }
+        // 根为团簇内最小索引, parent[i] <= i, 升序一遍即完全压缩
+        roots[s].clear();
+        for (int i = lo; i < hi; ++i) {
+            int p = parent[i];
+            if (p < 0) continue;
+            if (p == i) roots[s].push_back(i);
+            else parent[i] = parent[p];
+        }
+    }
+
+    DomainStats collect() {
+        const int L = lat.size(), plane = lat.stride(0);
+        pool.run([&](int w) {
+            for (int s = w; s < n_slabs; s += pool.size()) {
+                Partial& p = partial[s];
+                p = Partial();
+                for (int r : roots[s]) {
+                    if (parent[r] != r) continue; // 已并入其他平板的畴
+                    long long size = count[r].load(memory_order_relaxed);
+                    int b = 0;
+                    while ((2LL << b) <= size) ++b;
+                    if ((int)p.hist.size() <= b) p.hist.resize(b + 1, 0);
+                    p.hist[b]++;
+                    p.n++;
+                    p.atoms += size;
+                    p.sumsq += size * size;
+                    p.max_size = max(p.max_size, size);
+                    if (size >= L) p.big.push_back(r);
+                }
+            }
+        });
+
+        DomainStats d;
+        long long sumsq = 0;
+        vector<int> big;
+        for (const Partial& p : partial) {
+            d.n_domains += p.n;
+            d.n_atoms += p.atoms;
+            sumsq += p.sumsq;
+            d.max_size = max(d.max_size, p.max_size);
+            if (d.histogram.size() < p.hist.size()) d.histogram.resize(p.hist.size(), 0);
+            for (size_t b = 0; b < p.hist.size(); ++b) d.histogram[b] += p.hist[b];
+            big.insert(big.end(), p.big.begin(), p.big.end());
+        }
+        d.mean_size = d.n_domains ? (double)d.n_atoms / d.n_domains : 0.0;
+        d.weighted_mean = d.n_atoms ? (double)sumsq / d.n_atoms : 0.0;
+        if (big.empty()) return d;
+
+        // 贯穿检查 (Machta / Newman-Ziff 的绕数判据): 从根出发遍历候选畴, 记录每个格点展开坐标相对根的周期像;
+        // 畴内一条键连到已访问的格点, 而两端的像之差与该键的跨边界次数不符时, 该畴含一个绕数非零的回路,
+        // 即在周期边界下贯穿. 只占满各平面而不回绕的畴 (如在横向错开后首尾相接的阶梯) 不计入.
+        // 畴互不相交, 各线程分领候选; count 此时已不再需要, 用作像的存储 (-1 为未访问)
+        const int K = (int)big.size(), D = Lat::dim;
+        vector<char> wraps(K, 0);
+        queues.resize(pool.size());
+        pool.run([&](int w) {
+            for (int s = w; s < n_slabs; s += pool.size()) {
+                for (int i = slab_x[s] * plane; i < slab_x[s + 1] * plane; ++i) count[i].store(-1, memory_order_relaxed);
+            }
+        });
+        pool.run([&](int w) {
+            vector<int>& queue = queues[w];
+            for (int k = w; k < K; k += pool.size()) {
+                int r = big[k];
+                queue.clear();
+                queue.push_back(r);
+                count[r].store(0, memory_order_relaxed);
+                for (size_t q = 0; q < queue.size() && !wraps[k]; ++q) {
+                    int i = queue[q];
+                    typename Lat::Coord c = lat.coords(i);
+                    int img = count[i].load(memory_order_relaxed);
+                    for (int dir = 0; dir < Lat::z; ++dir) {
+                        int j = lat.neighbor(c, i, dir);
+                        if (parent[j] != r) continue;
+                        int jmg = img;
+                        for (int a = 0; a < D; ++a) {
+                            int x = c[a] + ((dir & 1) ? -1 : 1) * Lat::geometry::bond(dir >> 1, a);
+                            int dw = x < 0 ? -1 : (x >= L ? 1 : 0);
+                            if (dw) {
+                                int f = a * wbits;
+                                jmg = (jmg & ~(wmask << f)) | ((((jmg >> f) + dw) & wmask) << f);
+                            }
+                        }
+                        int seen = count[j].load(memory_order_relaxed);
+                        if (seen < 0) {
+                            count[j].store(jmg, memory_order_relaxed);
+                            queue.push_back(j);
+                        } else if (seen != jmg) {
+                            wraps[k] = 1;
+                            break;
+                        }
+                    }
+                }
+            }
+        });
+        for (int k = 0; k < K; ++k) d.n_spanning += wraps[k];
+        return d;
+    }
+};
+
+// 单次调用的便捷接口 (每次构造线程池与工作区, 循环中请复用 DomainLabeler)
+template <class Lat, class Sites>
+DomainStats label_domains(const Lat& lat, const Sites& sites, int n_threads = 0) {
+    DomainLabeler<Lat> labeler(lat, n_threads);
+    return labeler.measure(sites);
+}
+
+// 输出: domains_t_X.txt 为 "s_min\ts_max\t畴数" (对数分格); 汇总行追加到 summary
+//       (mcs, 畴数, 平均大小, 加权平均大小, 最大畴, 贯穿畴数)
+inline void write_domains(const DomainStats& d, const string& dir, int mcs, ostream& summary) {
+    ofstream out(dir + "/domains_t_" + to_string(mcs) + ".txt");
+    for (size_t b = 0; b < d.histogram.size(); ++b) {
+        out << (1LL << b) << "\t" << (2LL << b) - 1 << "\t" << d.histogram[b] << "\n";
+    }
+    summary << mcs << "\t" << d.n_domains << "\t" << fixed << setprecision(4) << d.mean_size << "\t"
+            << d.weighted_mean << "\t" << d.max_size << "\t" << d.n_spanning << "\n";
+    summary.unsetf(ios::fixed);
+}
+
+#endif
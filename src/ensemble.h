@@ -0,0 +1,287 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <vector>
+#include <cmath>
+#include <string>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <cstdint>
+#include "vacancy_engine.h"
+#include "structure_factor.h"
+#include "multispin_kawasaki.h"
+#include "interleaved.h"
+
+using namespace std;
+
+// 在线统计量: 均值与标准误差
+struct RunningStats {
+    double sum = 0.0, sumsq = 0.0;
+    long long n = 0;
+
+    void add(double x) { sum += x; sumsq += x * x; ++n; }
+    void merge(const RunningStats& o) { sum += o.sum; sumsq += o.sumsq; n += o.n; }
+    double mean() const { return n > 0 ? sum / n : 0.0; }
+    // 标准误差 sqrt(样本方差 / n)
+    double sem() const {
+        if (n < 2) return 0.0;
+        double var = (sumsq - sum * sum / n) / (n - 1);
+        return var > 0 ? sqrt(var / n) : 0.0;
+    }
+};
+
+// 采样时刻 t = 0, 1, 2, 4, ..., 2^n 以及 num_mc (与单次驱动程序一致)
+inline vector<int> log2_sample_times(int num_mc) {
+    vector<int> t{0};
+    for (long long p = 1; p < num_mc; p *= 2) t.push_back((int)p);
+    if (num_mc > 0) t.push_back(num_mc);
+    return t;
+}
+
+// log R = a + b log t 的最小二乘拟合 (自然对数), 只用 t_min <= t <= t_max 且 t, R > 0 的点;
+// err 为斜率的标准误差 (由残差估计, 点数 > 2 时)
+struct LogLogFit {
+    double slope = 0.0, intercept = 0.0, err = 0.0;
+    int n = 0;
+};
+
+template <class Time>
+inline LogLogFit loglog_fit(const vector<Time>& t, const vector<double>& R, double t_min, double t_max = HUGE_VAL) {
+    LogLogFit f;
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    auto used = [&](size_t i) { return t[i] >= t_min && t[i] <= t_max && t[i] > 0 && R[i] > 0; };
+    for (size_t i = 0; i < t.size(); ++i) {
+        if (!used(i)) continue;
+        double x = log((double)t[i]), y = log(R[i]);
+        sx += x; sy += y; sxx += x * x; sxy += x * y; ++f.n;
+    }
+    if (f.n < 2) return f;
+    double den = f.n * sxx - sx * sx;
+    if (den <= 0) return f;
+    f.slope = (f.n * sxy - sx * sy) / den;
+    f.intercept = (sy - f.slope * sx) / f.n;
+    if (f.n > 2) {
+        double ss = 0;
+        for (size_t i = 0; i < t.size(); ++i) {
+            if (!used(i)) continue;
+            double e = log(R[i]) - f.intercept - f.slope * log((double)t[i]);
+            ss += e * e;
+        }
+        f.err = sqrt(ss / (f.n - 2) * f.n / den);
+    }
+    return f;
+}
+
+// log R 对 log t 的最小二乘斜率, 只用 t >= t_min 的点
+inline double loglog_slope(const vector<int>& t, const vector<double>& R, int t_min) {
+    return loglog_fit(t, R, t_min).slope;
+}
+
+struct EnsembleParams {
+    int L = 128;
+    double T = 2.269 / 2.0, J = 1.0;
+    int num_mc = 1 << 20;
+    int replicas = 16;
+    int threads = 0;          // 0 = 全部硬件线程
+    uint64_t seed = 12345;    // 基础种子; 第 k 个副本使用子流 make_stream(seed, k)
+    int fit_t_min = 64;       // 标度指数拟合窗口下限
+    bool rejection_free = false; // 无拒绝 (BKL) 核, 低温时更快
+    int interleave = 1;       // > 1: 每个工作单元在一个线程内交错推进的副本数 (见 interleaved.h), 结果与逐个运行相同
+};
+
+// 所有副本在每个采样时刻的累积统计 (内存中归约, 不写单个副本文件)
+struct EnsembleAccumulator {
+    vector<int> times;
+    vector<RunningStats> R, R_zero, R_k;
+    vector<vector<RunningStats>> Cr;
+    RunningStats slope_energy, slope_zero;
+
+    EnsembleAccumulator(const vector<int>& t, int max_r)
+        : times(t), R(t.size()), R_zero(t.size()), R_k(t.size()),
+          Cr(t.size(), vector<RunningStats>(max_r + 1)) {}
+
+    void merge(const EnsembleAccumulator& o) {
+        for (size_t i = 0; i < times.size(); ++i) {
+            R[i].merge(o.R[i]); R_zero[i].merge(o.R_zero[i]); R_k[i].merge(o.R_k[i]);
+            for (size_t r = 0; r < Cr[i].size(); ++r) Cr[i][r].merge(o.Cr[i][r]);
+        }
+        slope_energy.merge(o.slope_energy);
+        slope_zero.merge(o.slope_zero);
+    }
+};
+
+// 单个副本: 独立、可复现的随机数流, 结果加入线程本地的累积器
+template <class Engine>
+void run_replica(const EnsembleParams& p, int replica, EnsembleAccumulator& acc) {
+    Rng gen = make_stream(p.seed, replica);
+    Engine engine(p.L, p.T, p.J);
+    engine.initialize(gen);
+    engine.rejection_free = p.rejection_free;
+    StructureFactor<typename Engine::lattice_type> sf(engine.lat);
+
+    vector<double> R(acc.times.size()), R0(acc.times.size());
+    size_t next = 0;
+    for (int mcs = 0; mcs <= p.num_mc && next < acc.times.size(); ++mcs) {
+        engine.mcs(gen);
+        if (mcs != acc.times[next]) continue;
+        StructureData sd = sf.measure(engine.sites);
+        R[next] = engine.R_energy();
+        R0[next] = sd.R_zero;
+        acc.R[next].add(R[next]);
+        acc.R_zero[next].add(sd.R_zero);
+        acc.R_k[next].add(sd.R_k);
+        for (size_t r = 0; r < sd.C_axial.size(); ++r) acc.Cr[next][r].add(sd.C_axial[r]);
+        ++next;
+    }
+    acc.slope_energy.add(loglog_slope(acc.times, R, p.fit_t_min));
+    acc.slope_zero.add(loglog_slope(acc.times, R0, p.fit_t_min));
+}
+
+// 交错执行的一组副本 first .. first + count - 1: 每个副本的随机数流与轨迹都与 run_replica 相同,
+// 只是同一线程内轮流推进 (见 interleaved.h)
+template <class Engine>
+void run_interleaved_group(const EnsembleParams& p, int first, int count, EnsembleAccumulator& acc) {
+    vector<Rng> gens;
+    vector<Engine> engines;
+    for (int k = 0; k < count; ++k) {
+        gens.push_back(make_stream(p.seed, first + k));
+        engines.emplace_back(p.L, p.T, p.J);
+        engines[k].initialize(gens[k]);
+        engines[k].rejection_free = p.rejection_free;
+    }
+    StructureFactor<typename Engine::lattice_type> sf(engines[0].lat);
+
+    vector<vector<double>> R(count, vector<double>(acc.times.size())), R0 = R;
+    size_t next = 0;
+    for (int mcs = 0; mcs <= p.num_mc && next < acc.times.size(); ++mcs) {
+        interleaved_mcs(engines, gens);
+        if (mcs != acc.times[next]) continue;
+        for (int k = 0; k < count; ++k) {
+            StructureData sd = sf.measure(engines[k].sites);
+            R[k][next] = engines[k].R_energy();
+            R0[k][next] = sd.R_zero;
+            acc.R[next].add(R[k][next]);
+            acc.R_zero[next].add(sd.R_zero);
+            acc.R_k[next].add(sd.R_k);
+            for (size_t r = 0; r < sd.C_axial.size(); ++r) acc.Cr[next][r].add(sd.C_axial[r]);
+        }
+        ++next;
+    }
+    for (int k = 0; k < count; ++k) {
+        acc.slope_energy.add(loglog_slope(acc.times, R[k], p.fit_t_min));
+        acc.slope_zero.add(loglog_slope(acc.times, R0[k], p.fit_t_min));
+    }
+}
+
+// 多自旋编码的一组副本 (Engine::replicas 个, 共用随机数流 make_stream(seed, group), 见 multispin_kawasaki.h):
+// 能量与 C(r) 按位并行统计, R_zero / R_k 由每个副本解码后的 S(k) 求出.
+// 各副本的接受判定用独立随机数 (见 multispin_kawasaki.h), 每个副本作为一个样本
+template <class Engine>
+void run_multispin_group(const EnsembleParams& p, int group, EnsembleAccumulator& acc) {
+    Rng gen = make_stream(p.seed, group);
+    Engine engine(p.L, p.T, p.J);
+    engine.initialize(gen);
+    StructureFactor<typename Engine::lattice_type> sf(engine.lat);
+
+    const int n = Engine::replicas;
+    vector<vector<double>> R(n, vector<double>(acc.times.size())), R0 = R;
+    size_t next = 0;
+    for (int mcs = 0; mcs <= p.num_mc && next < acc.times.size(); ++mcs) {
+        engine.mcs(gen);
+        if (mcs != acc.times[next]) continue;
+        vector<double> Re = engine.R_energies();
+        vector<vector<double>> C = engine.correlations();
+        for (int k = 0; k < n; ++k) {
+            StructureData sd = sf.measure(engine.replica_sites(k), 0);
+            R[k][next] = Re[k];
+            R0[k][next] = sd.R_zero;
+            acc.R[next].add(Re[k]);
+            acc.R_zero[next].add(sd.R_zero);
+            acc.R_k[next].add(sd.R_k);
+            for (size_t r = 0; r < C[k].size(); ++r) acc.Cr[next][r].add(C[k][r]);
+        }
+        ++next;
+    }
+    for (int k = 0; k < n; ++k) {
+        acc.slope_energy.add(loglog_slope(acc.times, R[k], p.fit_t_min));
+        acc.slope_zero.add(loglog_slope(acc.times, R0[k], p.fit_t_min));
+    }
+}
+
+// 每个工作单元的副本数: 多自旋编码引擎为 Engine::replicas, 其余为 1
+template <class E, class = void>
+struct replicas_per_unit { static constexpr int value = 1; };
+template <class E>
+struct replicas_per_unit<E, void_t<decltype(E::replicas)>> { static constexpr int value = E::replicas; };
+
+// 工作池: 每个线程从共享计数器领取副本编号, 结束后把本地累积器合并到结果中
+template <class Engine>
+EnsembleAccumulator run_ensemble(const EnsembleParams& p) {
+    vector<int> times = log2_sample_times(p.num_mc);
+    EnsembleAccumulator total(times, p.L / 2);
+    int n_threads = p.threads > 0 ? p.threads : max(1u, thread::hardware_concurrency());
+    constexpr int per_unit = replicas_per_unit<Engine>::value;
+    const int units = (p.replicas + per_unit - 1) / per_unit; // 多自旋编码时副本数向上取整到整组
+    const int group = per_unit == 1 ? max(1, p.interleave) : 1; // 交错执行时每个工作单元领取的副本数
+    n_threads = min(n_threads, (units + group - 1) / group);
+
+    atomic<int> next_replica(0);
+    mutex merge_mutex;
+    vector<thread> pool;
+    for (int w = 0; w < n_threads; ++w) {
+        pool.emplace_back([&]() {
+            EnsembleAccumulator local(times, p.L / 2);
+            for (int k; (k = next_replica.fetch_add(group)) < units;) {
+                if constexpr (per_unit > 1) run_multispin_group<Engine>(p, k, local);
+                else if (group > 1) run_interleaved_group<Engine>(p, k, min(group, units - k), local);
+                else run_replica<Engine>(p, k, local);
+                lock_guard<mutex> lock(merge_mutex);
+                if (group > 1) cout << "Replicas " << k << ".." << min(k + group, units) - 1 << " done" << endl;
+                else cout << (per_unit > 1 ? "Replica group " : "Replica ") << k << " done" << endl;
+            }
+            lock_guard<mutex> lock(merge_mutex);
+            total.merge(local);
+        });
+    }
+    for (auto& t : pool) t.join();
+    return total;
+}
+
+// 标准误差列: 少于 2 个独立样本时没有误差估计, 写 nan
+inline string sem_text(const RunningStats& s) {
+    if (s.n < 2) return "nan";
+    ostringstream o;
+    o << fixed << setprecision(6) << s.sem();
+    return o.str();
+}
+
+// 输出: R_ensemble.txt (t, n, R, err, R_zero, err, R_k, err), Cr_mean_t_X.txt (r, C, err),
+//       exponent.txt (各副本拟合斜率的均值与标准误差); n 为副本数
+inline void save_ensemble(const EnsembleAccumulator& acc, const EnsembleParams& p, const string& dir) {
+    ofstream r_out(dir + "/R_ensemble.txt");
+    r_out << "# t\tn\tR_energy\terr\tR_zero\terr\tR_k\terr\n";
+    for (size_t i = 0; i < acc.times.size(); ++i) {
+        r_out << acc.times[i] << "\t" << acc.R[i].n << fixed << setprecision(6)
+              << "\t" << acc.R[i].mean() << "\t" << sem_text(acc.R[i])
+              << "\t" << acc.R_zero[i].mean() << "\t" << sem_text(acc.R_zero[i])
+              << "\t" << acc.R_k[i].mean() << "\t" << sem_text(acc.R_k[i]) << "\n";
+        r_out.unsetf(ios::fixed);
+        ofstream c_out(dir + "/Cr_mean_t_" + to_string(acc.times[i]) + ".txt");
+        for (size_t r = 0; r < acc.Cr[i].size(); ++r) {
+            c_out << r << "\t" << fixed << setprecision(6) << acc.Cr[i][r].mean() << "\t" << sem_text(acc.Cr[i][r]) << "\n";
+        }
+    }
+    ofstream e_out(dir + "/exponent.txt");
+    e_out << "# log-log fit over t >= " << p.fit_t_min << ", replicas = " << acc.slope_energy.n
+          << ", seed = " << p.seed << ", rng = " << rng_name << "\n";
+    e_out << "R_energy\t" << acc.slope_energy.mean() << "\t" << sem_text(acc.slope_energy) << "\n";
+    e_out << "R_zero\t" << acc.slope_zero.mean() << "\t" << sem_text(acc.slope_zero) << "\n";
+}
+
+#endif
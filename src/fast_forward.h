@@ -0,0 +1,314 @@
+#ifndef FAST_FORWARD_H
+#define FAST_FORWARD_H
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <map>
+#include <climits>
+#include "vacancy_kernel.h"
+#include "coarse_grain.h"
+
+using namespace std;
+
+// 纯畴内空位随机行走的快进 (正方 / 简单立方).
+// 空位周围 L∞ 距离 R 以内全是同种原子 s 时, 从 v 到邻居 n 的每次尝试都有 S_v = z s, S_n = (z-1) s, de = 0,
+// 必被接受且不消耗随机数; 换位的两个原子同种, 构型除空位位置外不变. 于是在以起点为中心、半径 r = R - 2 的
+// 盒子里空位做简单随机行走 (每次尝试 2D 个方向等概率, 一次尝试一步), 直到第一次走出盒子.
+// 整段行走用首达分布一次抽出: 步数 T 即消耗的尝试数 (MCS 时钟精确), 出口点 e 处的原子与起点交换一次即可.
+
+// 从 [-r, r]^D 盒子中心出发的首达分布 (动态规划, 精确到双精度):
+//   cdf_T      P(T <= t), 第 t - 1 项; 截断到 T_max, 此后存活概率 < tail
+//   cdf_face   给定 T = t 时出口点的条件累积分布 (第 t - 1 行): 出口点恰有一个坐标为 ±(r+1) (出口面),
+//              由超立方对称性, 出口面 2D 个等概率, 面内 D - 1 个坐标按绝对值排序约化到 face 中的代表点,
+//              抽样时再随机置换与翻转 (对称群上均匀, 即在代表点的轨道上均匀)
+//   cdf_stay   T > T_max 时 T_max 步后位置 (盒内 (2r+1)^D 点) 的条件累积分布
+template <int D>
+struct FirstPassageTable {
+    using Face = array<int, D - 1>;
+    int r = 0, T_max = 0;
+    double mean_T = 0.0;
+    vector<Face> face;
+    vector<double> cdf_T, cdf_face, cdf_stay;
+
+    explicit FirstPassageTable(int r_, double tail = 1e-15) : r(r_) {
+        const int w = 2 * r + 1;
+        int n = 1;
+        for (int a = 0; a < D; ++a) n *= w;
+        // 约化的面内坐标 0 <= y_1 <= ... <= y_{D-1} <= r
+        map<Face, int> canon;
+        Face y{};
+        for (;;) {
+            canon.emplace(y, 0);
+            int k = D - 2;
+            while (k >= 0 && y[k] == r) --k;
+            if (k < 0) break;
+            int v = y[k] + 1;
+            for (int j = k; j < D - 1; ++j) y[j] = v;
+        }
+        for (auto& [f, id] : canon) { id = (int)face.size(); face.push_back(f); }
+        const int F = (int)face.size();
+
+        // 每个盒内点的坐标, 以及沿第 a 轴走出时出口点的代表点编号
+        vector<array<int, D>> x(n);
+        vector<int> exit_face(n * D);
+        for (int i = 0; i < n; ++i) {
+            for (int a = D - 1, k = i; a >= 0; --a) { x[i][a] = k % w - r; k /= w; }
+            for (int a = 0; a < D; ++a) {
+                Face f{};
+                for (int c = 0, k = 0; c < D; ++c) if (c != a) f[k++] = abs(x[i][c]);
+                sort(f.begin(), f.end());
+                exit_face[i * D + a] = canon[f];
+            }
+        }
+        int stride[D];
+        for (int a = D - 1, s = 1; a >= 0; --a) { stride[a] = s; s *= w; }
+
+        vector<double> P(n, 0.0), Q(n), row(F);
+        P[n / 2] = 1.0;
+        double cum = 0.0, survive = 1.0;
+        for (int t = 1; survive > tail; ++t) {
+            fill(Q.begin(), Q.end(), 0.0);
+            fill(row.begin(), row.end(), 0.0);
+            for (int i = 0; i < n; ++i) {
+                if (P[i] == 0.0) continue;
+                double p = P[i] / (2 * D);
+                for (int a = 0; a < D; ++a) {
+                    if (x[i][a] < r) Q[i + stride[a]] += p; else row[exit_face[i * D + a]] += p;
+                    if (x[i][a] > -r) Q[i - stride[a]] += p; else row[exit_face[i * D + a]] += p;
+                }
+            }
+            swap(P, Q);
+            double f = 0.0;
+            for (double v : row) f += v;
+            survive = 0.0;
+            for (double v : P) survive += v;
+            cum += f;
+            mean_T += t * f;
+            cdf_T.push_back(cum);
+            double acc = 0.0;
+            for (int k = 0; k < F; ++k) {
+                acc += row[k];
+                cdf_face.push_back(f > 0 ? acc / f : 1.0);
+            }
+        }
+        T_max = (int)cdf_T.size();
+        mean_T += T_max * survive;
+        double acc = 0.0;
+        for (int i = 0; i < n; ++i) { acc += P[i]; cdf_stay.push_back(acc / survive); }
+    }
+};
+
+// 快进器: 用粗粒化块和 (coarse_grain.h) 判断空位是否处在纯畴内部.
+// 块的纯净状态: |B| >= b^D - 1 时为 sign B (b^D 为偶数, |B| = b^D - 1 只能是含空位且其余全同种的块), 否则 0.
+// 以空位所在块为中心向外逐圈检查, 第 1..k 圈的块都与中心块同种且纯净时, 空位在块内的偏移 o 给出
+// 纯区域半径 R = min_a min(o_a + k b, (k+1) b - 1 - o_a) >= k b, 盒子半径取 r = min(R - 2, r_max).
+// 空位在纯畴内行走时各块的状态不变 (只是空位换了块), 所以每个块的圈数都缓存起来,
+// 只有某个块的状态改变 (界面附近的跳跃) 时才整体作废 (version 加一).
+// 一段 MCS 剩余的尝试不足 T_max(r) 时换更小的盒子或逐次尝试, 保证不越过采样时刻.
+// r_max 为 2D 16 / 3D 8 (表的大小与建表时间随 r^D T_max 增长); b < 2 或 L / b < 3 时不快进
+template <class Lat>
+class BulkWalk {
+public:
+    static_assert(Lat::geometry::axial, "快进只支持正方 / 简单立方晶格");
+    static constexpr int D = Lat::dim;
+    static constexpr int r_min = 2; // 更小的盒子平均只走几步, 不抵抽样的开销
+    using Coord = typename Lat::Coord;
+
+    CoarseGrid<Lat>& grid; // 快进核负责维护它 (每次接受的跳跃与每段快进都调用 moved)
+    long long walks = 0, walked_attempts = 0; // 快进次数与其中包含的尝试数
+
+    BulkWalk(const Lat& lat, CoarseGrid<Lat>& grid_, int r_max_ = D == 2 ? 16 : 8)
+        : grid(grid_), b(grid_.block_size()), L(lat.size()) {
+        const int Lc = L / b;
+        k_max = b < 2 ? 0 : min((r_max_ + 2 + b - 1) / b, (Lc - 1) / 2);
+        r_max = k_max > 0 ? min(r_max_, k_max * b + (b - 1) / 2 - 2) : 0;
+        block_volume = 1;
+        for (int a = 0; a < D; ++a) block_volume *= b;
+        for (int r = 1; r <= r_max; ++r) tables.emplace_back(r);
+        memo.assign(grid.sums().size(), Memo{});
+    }
+
+    // 块和被整体重建后 (续算) 清掉缓存
+    void reset() { ++version; }
+
+    // 代替 grid.moved: 跨块的跳跃改变了某个块的纯净状态时作废圈数缓存. 跨块时两个块和各变 ±1,
+    // 状态只在 |B| 于 b^D - 2 与 b^D - 1 之间变化时改变, 即新旧 |B| 之和为 2b^D - 3
+    inline void moved(const Coord& from, const Coord& to, int s) {
+        int t = grid.vacancy_cell();
+        grid.moved(from, to, s);
+        int f = grid.vacancy_cell();
+        const vector<int>& B = grid.sums();
+        int bt = B[t], bf = B[f];
+        version += (f != t) & ((abs(bt) + abs(bt - s) == 2 * block_volume - 3) | (abs(bf) + abs(bf + s) == 2 * block_volume - 3));
+    }
+
+    // 邻居全是 s 的空位可用的盒子半径, 0 表示不能快进
+    inline int radius(const Coord& vc, int s, long long remaining) {
+        int cell = grid.vacancy_cell();
+        Memo& m = memo[cell];
+        if (m.version != version) pure_rings(cell, vc, m);
+        if (m.species != s) return 0;
+        int R = INT_MAX;
+        for (int a = 0; a < D; ++a) {
+            int o = vc[a] & (b - 1);
+            R = min(R, min(o + m.rings * b, (m.rings + 1) * b - 1 - o));
+        }
+        int r = min(R - 2, r_max);
+        while (r >= r_min && tables[r - 1].T_max > remaining) --r;
+        return r >= r_min ? r : 0;
+    }
+
+    // 在半径 r 的盒子内快进: 抽出 (T, 出口点), 出口点的原子 s 移到空位, 返回消耗的尝试数 T
+    template <class Sites, class URBG, class Probe>
+    long long walk(const Lat& lat, Sites& sites, Coord& vc, int& v_pos, int s, int r, URBG& gen, Probe& probe) {
+        const FirstPassageTable<D>& tab = tables[r - 1];
+        const int F = (int)tab.face.size();
+        Coord d{};
+        long long T;
+        double u = uniform53(gen);
+        if (u < tab.cdf_T.back()) {
+            T = upper_bound(tab.cdf_T.begin(), tab.cdf_T.end(), u) - tab.cdf_T.begin() + 1;
+            const double* row = &tab.cdf_face[(T - 1) * F];
+            double v = uniform53(gen);
+            int f = 0;
+            while (f < F - 1 && v >= row[f]) ++f;
+            auto y = tab.face[f];
+            for (int k = D - 2; k > 0; --k) swap(y[k], y[uniform_below(gen, k + 1)]);
+            uint32_t flips = static_cast<uint32_t>(gen());
+            int side = (int)uniform_below(gen, 2 * D);
+            int a = side >> 1;
+            d[a] = (side & 1) ? -(r + 1) : r + 1;
+            for (int c = 0, k = 0; c < D; ++c) {
+                if (c != a) { d[c] = ((flips >> k) & 1) ? -y[k] : y[k]; ++k; }
+            }
+        } else {
+            // T_max 步仍未走出: 按存活条件下的位置分布落点, 之后照常继续
+            T = tab.T_max;
+            int i = (int)(upper_bound(tab.cdf_stay.begin(), tab.cdf_stay.end(), uniform53(gen)) - tab.cdf_stay.begin());
+            i = min(i, (int)tab.cdf_stay.size() - 1);
+            for (int a = D - 1; a >= 0; --a) { d[a] = i % (2 * r + 1) - r; i /= 2 * r + 1; }
+        }
+        Coord nc;
+        for (int a = 0; a < D; ++a) {
+            int c = vc[a] + d[a];
+            nc[a] = c < 0 ? c + L : c >= L ? c - L : c;
+        }
+        int n_idx = lat.index(nc);
+        grid.moved(nc, vc, s); // 纯区域内: 块的状态不变
+        probe.moved(nc, vc, s);
+        probe.walked(T, d);
+        move_atom(sites, n_idx, v_pos, s);
+        vc = nc;
+        v_pos = n_idx;
+        ++walks;
+        walked_attempts += T;
+        return T;
+    }
+
+private:
+    struct Memo {
+        long long version = -1;
+        int species = 0, rings = 0;
+    };
+
+    int b, L;
+    int block_volume, k_max, r_max;
+    long long version = 0;
+    vector<FirstPassageTable<D>> tables; // 半径 1..r_max
+    vector<Memo> memo;                   // 按粗晶格索引
+
+    inline int status(int B) const { return abs(B) >= block_volume - 1 ? (B > 0) - (B < 0) : 0; }
+
+    // 块 cell (空位所在) 外有几圈块与它同种且纯净 (最多 k_max 圈); 一圈都没有时种类记 0
+    void pure_rings(int cell, const Coord& vc, Memo& m) const {
+        const auto& clat = grid.lattice();
+        const vector<int>& B = grid.sums();
+        const int Lc = clat.size();
+        m = Memo{version, 0, 0};
+        int s = status(B[cell]);
+        if (s == 0) return;
+        int home[D];
+        for (int a = 0; a < D; ++a) home[a] = vc[a] / b;
+        typename CoarseGrid<Lat>::Coord cc;
+        for (int k = 1; k <= k_max; ++k) {
+            // 第 k 圈: (2k+1)^D 个块中至少有一个偏移分量为 ±k 的那些
+            int offset[D];
+            for (int a = 0; a < D; ++a) offset[a] = -k;
+            for (;;) {
+                bool ring = false;
+                for (int a = 0; a < D; ++a) {
+                    int c = home[a] + offset[a];
+                    cc[a] = c < 0 ? c + Lc : c >= Lc ? c - Lc : c;
+                    ring = ring || offset[a] == k || offset[a] == -k;
+                }
+                if (ring && status(B[clat.index(cc)]) != s) return;
+                int a = D - 1;
+                while (a >= 0 && offset[a] == k) offset[a--] = -k;
+                if (a < 0) break;
+                ++offset[a];
+            }
+            m.species = s;
+            m.rings = k;
+        }
+    }
+};
+
+// 带快进的 Metropolis 空位核: 与 vacancy_sweep 是同一个离散时间马尔可夫链.
+// 要求 bulk.grid 的块和与 sites 一致 (rebuild 之后才开始调用).
+// 空位的邻居全同种 (S_v = ±z) 时询问 bulk 能否快进; 其余尝试与 vacancy_sweep 逐次相同.
+// 快进段对 probe 只报告一次 moved (净位移) 与 walked(T, 位移); bulk.grid 由本核经 bulk.moved 维护,
+// 不要再把同一个 CoarseGrid 作为 probe 传入
+template <class Lat, class Sites, class URBG, class Probe = NullProbe>
+long long vacancy_sweep_fast_forward(const Lat& lat, const MetropolisTable& table, Sites& sites,
+                                     typename Lat::Coord& vc, int& v_pos, long long n_attempts, URBG& gen,
+                                     BulkWalk<Lat>& bulk, Probe&& probe = Probe()) {
+    constexpr int z = Lat::z;
+    long long de_total = 0;
+    typename Lat::Coord vc_ = vc; int v_pos_ = v_pos;
+    int v_sum = lat.neighbor_sum(sites, vc_, v_pos_);
+    for (long long remaining = n_attempts; remaining > 0;) {
+        if (v_sum == z || v_sum == -z) {
+            int s = v_sum / z;
+            int r = bulk.radius(vc_, s, remaining);
+            // 出口点仍在纯区域内, 新空位的邻居和不变
+            if (r > 0) { remaining -= bulk.walk(lat, sites, vc_, v_pos_, s, r, gen, probe); continue; }
+        }
+        --remaining;
+        int dir = static_cast<int>((static_cast<uint64_t>(static_cast<uint32_t>(gen())) * z) >> 32);
+        typename Lat::Coord nc = vc_;
+        lat.advance(nc, dir);
+        int n_idx = lat.neighbor(vc_, v_pos_, dir);
+
+        int s = sites[n_idx];
+        int n_sum = lat.neighbor_sum(sites, nc, n_idx);
+        int de = s * (n_sum - v_sum) + 1;
+
+        bool accepted = table.accept(de, gen);
+        probe.hop(de, accepted, dir);
+        if (accepted) {
+            bulk.moved(nc, vc_, s);
+            probe.moved(nc, vc_, s);
+            move_atom(sites, n_idx, v_pos_, s);
+            de_total += de;
+            v_pos_ = n_idx;
+            vc_ = nc;
+            v_sum = n_sum + s;
+        }
+    }
+    vc = vc_; v_pos = v_pos_;
+    return de_total;
+}
+
+// 引擎上的 n_attempts 次尝试 / 一个 MCS (N 次尝试), 对应 VacancyEngine::sweep / mcs
+template <class Engine, class URBG, class Probe = NullProbe>
+void sweep_fast_forward(Engine& e, long long n_attempts, URBG& g, BulkWalk<typename Engine::lattice_type>& bulk, Probe&& probe = Probe()) {
+    e.energy += vacancy_sweep_fast_forward(e.lat, e.table, e.sites, e.vc, e.v_pos, n_attempts, g, bulk, probe);
+}
+
+template <class Engine, class URBG, class Probe = NullProbe>
+void mcs_fast_forward(Engine& e, URBG& g, BulkWalk<typename Engine::lattice_type>& bulk, Probe&& probe = Probe()) {
+    sweep_fast_forward(e, e.lat.sites(), g, bulk, probe);
+}
+
+#endif
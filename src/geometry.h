@@ -0,0 +1,90 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+// 晶格几何: 格点为 D 维整数坐标 (以原胞基矢为坐标轴, 每轴 L 个, 周期边界), 最近邻由编译期偏移表给出.
+// 偏移表 bond(k, a) 为第 k 个键方向 v_k 的第 a 个分量 (分量 ∈ {-1, 0, 1}, 分量 0 轴上为 0 或 +1), 方向编号
+//   dir = 2k + (0: +v_k, 1: -v_k),   dir ^ 1 为反方向,
+// 前 D 个 v_k 是坐标轴本身, 因此正方 / 简单立方的方向编号与原来相同 (axial = true 时 Lattice 走原来的单轴路径).
+// metric(a, b) 为基矢的度规 a_a · a_b (以最近邻距离为单位), 用于距离、波矢与 MSD; 坐标轴方向的 C(r) 沿基矢方向测量.
+
+// 正方 (D = 2, z = 4) 与简单立方 (D = 3, z = 6)
+template <int D>
+struct HyperCubic {
+    static constexpr int dim = D;
+    static constexpr int z = 2 * D;
+    static constexpr bool axial = true;
+    static constexpr int bond(int k, int a) { return k == a ? 1 : 0; }
+    static constexpr double metric(int a, int b) { return a == b ? 1.0 : 0.0; }
+    static const char* name() { return D == 2 ? "square" : "cubic"; }
+};
+
+// 三角晶格 (z = 6): a1 = (1, 0), a2 = (1/2, √3/2), 第三个键 a1 - a2
+struct Triangular {
+    static constexpr int dim = 2;
+    static constexpr int z = 6;
+    static constexpr bool axial = false;
+    static constexpr int bonds[3][2] = {{1, 0}, {0, 1}, {1, -1}};
+    static constexpr double gram[2][2] = {{1.0, 0.5}, {0.5, 1.0}};
+    static constexpr int bond(int k, int a) { return bonds[k][a]; }
+    static constexpr double metric(int a, int b) { return gram[a][b]; }
+    static const char* name() { return "triangular"; }
+};
+
+// 体心立方 (z = 8): 原胞基矢 (-1,1,1)/2, (1,-1,1)/2, (1,1,-1)/2, 第四个键 a1 + a2 + a3
+struct BCC {
+    static constexpr int dim = 3;
+    static constexpr int z = 8;
+    static constexpr bool axial = false;
+    static constexpr int bonds[4][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 1, 1}};
+    static constexpr double gram[3][3] = {{1.0, -1.0 / 3, -1.0 / 3}, {-1.0 / 3, 1.0, -1.0 / 3}, {-1.0 / 3, -1.0 / 3, 1.0}};
+    static constexpr int bond(int k, int a) { return bonds[k][a]; }
+    static constexpr double metric(int a, int b) { return gram[a][b]; }
+    static const char* name() { return "bcc"; }
+};
+
+// 面心立方 (z = 12): 原胞基矢 (0,1,1)/2, (1,0,1)/2, (1,1,0)/2, 另三个键 a1 - a2, a2 - a3, a1 - a3
+struct FCC {
+    static constexpr int dim = 3;
+    static constexpr int z = 12;
+    static constexpr bool axial = false;
+    static constexpr int bonds[6][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, -1, 0}, {0, 1, -1}, {1, 0, -1}};
+    static constexpr double gram[3][3] = {{1.0, 0.5, 0.5}, {0.5, 1.0, 0.5}, {0.5, 0.5, 1.0}};
+    static constexpr int bond(int k, int a) { return bonds[k][a]; }
+    static constexpr double metric(int a, int b) { return gram[a][b]; }
+    static const char* name() { return "fcc"; }
+};
+
+// 最近邻 Ising 模型的临界温度 (k_B Tc / J)
+inline double critical_temperature(const string& geometry, int D) {
+    if (geometry == "triangular") return 3.641;
+    if (geometry == "bcc") return 6.355;
+    if (geometry == "fcc") return 9.794;
+    return D == 2 ? 2.269 : 4.51;
+}
+
+inline bool valid_geometry(const string& geometry, int D) {
+    if (D == 2) return geometry == "square" || geometry == "triangular";
+    return geometry == "cubic" || geometry == "bcc" || geometry == "fcc";
+}
+
+// 轨迹文件头中的几何编号: 0 正方 / 简单立方, 1 三角, 2 bcc, 3 fcc
+inline uint32_t geometry_id(const string& geometry) {
+    if (geometry == "triangular") return 1;
+    if (geometry == "bcc") return 2;
+    if (geometry == "fcc") return 3;
+    return 0;
+}
+
+inline string geometry_name(uint32_t id, int D) {
+    if (id == 1) return "triangular";
+    if (id == 2) return "bcc";
+    if (id == 3) return "fcc";
+    return D == 2 ? "square" : "cubic";
+}
+
+#endif
@@ -0,0 +1,230 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <vector>
+#include <array>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <chrono>
+#include <mutex>
+#include <cstdint>
+#include <iomanip>
+#include "vacancy_kernel.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// 可选的热路径插桩 (驱动程序中 instrument = true 时启用), 结果按采样时刻写成 JSON Lines:
+//   {"mcs", "since", "attempts", "accepted", "msd", "displacement", "de": {de: [接受, 拒绝]}, "skipped",
+//    "phases": {"kernel" | "measure" | "io": {"seconds", "calls", "cycles", "cache_misses", "branch_misses"}}}
+// 计数从 since (启动或续算的 MCS) 开始累计. 不启用时内核使用 NullProbe, 没有任何额外指令.
+
+// 插桩探针: 按 de 分类的接受 / 拒绝计数, 以及空位的展开位移 (不做周期折返, 原胞坐标)
+template <int D, class G = HyperCubic<D>>
+struct HopProbe {
+    static constexpr bool enabled = true;
+    int max_de = 0;
+    vector<long long> accepted, rejected; // 按 de + max_de 索引
+    long long skipped_attempts = 0;       // 无拒绝核跳过的尝试 (方向与 de 未知)
+    array<long long, D> displacement{};
+
+    HopProbe() = default;
+    explicit HopProbe(const MetropolisTable& table)
+        : max_de(table.max_de), accepted(2 * table.max_de + 1, 0), rejected(2 * table.max_de + 1, 0) {}
+
+    inline void hop(int de, bool ok, int dir) {
+        if (ok) {
+            ++accepted[de + max_de];
+            int sign = (dir & 1) ? -1 : 1;
+            if constexpr (G::axial) displacement[dir >> 1] += sign;
+            else for (int a = 0; a < D; ++a) displacement[a] += sign * G::bond(dir >> 1, a);
+        } else {
+            ++rejected[de + max_de];
+        }
+    }
+    inline void skipped(long long n) { skipped_attempts += n; }
+    template <class Coord>
+    inline void moved(const Coord&, const Coord&, int) {}
+    // 快进段: n 次 de = 0 的接受, 位移 d (原胞坐标)
+    template <class Disp>
+    inline void walked(long long n, const Disp& d) {
+        accepted[max_de] += n;
+        for (int a = 0; a < D; ++a) displacement[a] += d[a];
+    }
+
+    // 单空位的展开均方位移 |r(t) - r(since)|^2, 以最近邻距离为单位 (超立方时为整数)
+    double msd() const {
+        double r2 = 0.0;
+        for (int a = 0; a < D; ++a) {
+            for (int b = 0; b < D; ++b) r2 += G::metric(a, b) * displacement[a] * displacement[b];
+        }
+        return r2;
+    }
+};
+
+// 分阶段的硬件计数器: 周期数、缓存未命中、分支预测失败 (perf_event_open, 仅统计调用线程的用户态).
+// 每个线程各自打开一组; 不支持或无权限 (perf_event_paranoid、容器) 时 ok() 为 false, 只报告墙钟时间
+class PerfCounters {
+public:
+    static constexpr int n_events = 3;
+
+    PerfCounters() {
+#ifdef __linux__
+        const uint64_t config[n_events] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (int e = 0; e < n_events; ++e) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = config[e];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, e == 0 ? -1 : fds[0], 0);
+            if (fd < 0) { close_all(); return; }
+            fds[e] = fd;
+        }
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+    ~PerfCounters() { close_all(); }
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool ok() const { return fds[0] >= 0; }
+
+    // 当前计数值 (计数器自打开起连续运行, 阶段的计数取前后之差)
+    array<uint64_t, n_events> read_all() const {
+        array<uint64_t, n_events> v{};
+#ifdef __linux__
+        if (ok()) {
+            uint64_t buf[1 + n_events];
+            if (::read(fds[0], buf, sizeof(buf)) == (ssize_t)sizeof(buf)) {
+                for (int e = 0; e < n_events; ++e) v[e] = buf[1 + e];
+            }
+        }
+#endif
+        return v;
+    }
+
+    // 当前线程的计数器组 (第一次使用时打开)
+    static PerfCounters& this_thread() {
+        thread_local PerfCounters counters;
+        return counters;
+    }
+
+private:
+    int fds[n_events] = {-1, -1, -1};
+
+    void close_all() {
+#ifdef __linux__
+        for (int& fd : fds) if (fd >= 0) { ::close(fd); fd = -1; }
+#endif
+    }
+};
+
+enum Phase { phase_kernel, phase_measure, phase_io, n_phases };
+const char* const phase_names[n_phases] = {"kernel", "measure", "io"};
+
+// 分阶段计时: scope(p) 返回的对象在析构时把这段时间 (与硬件计数差值) 累加到阶段 p.
+// 可在多个线程中同时使用 (测量阶段在流水线的各工作线程中); enabled = false 时什么也不做
+class PhaseProfiler {
+public:
+    struct Totals {
+        double seconds = 0.0;
+        long long calls = 0;
+        array<uint64_t, PerfCounters::n_events> events{};
+        bool has_events = false;
+    };
+
+    class Scope {
+    public:
+        Scope(PhaseProfiler* p_, Phase ph_) : p(p_), ph(ph_) {
+            if (!p) return;
+            start_events = PerfCounters::this_thread().read_all();
+            start = chrono::steady_clock::now();
+        }
+        ~Scope() {
+            if (!p) return;
+            double s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            PerfCounters& pc = PerfCounters::this_thread();
+            array<uint64_t, PerfCounters::n_events> end_events = pc.read_all();
+            lock_guard<mutex> lock(p->m);
+            Totals& t = p->totals[ph];
+            t.seconds += s;
+            ++t.calls;
+            if (pc.ok()) {
+                t.has_events = true;
+                for (int e = 0; e < PerfCounters::n_events; ++e) t.events[e] += end_events[e] - start_events[e];
+            }
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        PhaseProfiler* p;
+        Phase ph;
+        array<uint64_t, PerfCounters::n_events> start_events{};
+        chrono::steady_clock::time_point start;
+    };
+
+    explicit PhaseProfiler(bool enabled_) : enabled(enabled_) {
+        if (enabled && !PerfCounters::this_thread().ok()) {
+            cerr << "perf_event_open 不可用, 插桩只记录墙钟时间" << endl;
+        }
+    }
+
+    Scope scope(Phase ph) { return Scope(enabled ? this : nullptr, ph); }
+
+    string json() {
+        lock_guard<mutex> lock(m);
+        ostringstream os;
+        os << "{";
+        for (int ph = 0; ph < n_phases; ++ph) {
+            const Totals& t = totals[ph];
+            os << (ph ? ", " : "") << "\"" << phase_names[ph] << "\": {\"seconds\": " << t.seconds << ", \"calls\": " << t.calls;
+            if (t.has_events) {
+                os << ", \"cycles\": " << t.events[0] << ", \"cache_misses\": " << t.events[1]
+                   << ", \"branch_misses\": " << t.events[2];
+            }
+            os << "}";
+        }
+        os << "}";
+        return os.str();
+    }
+
+private:
+    bool enabled;
+    mutex m;
+    Totals totals[n_phases];
+};
+
+// 一条采样记录 (一行 JSON)
+template <int D, class G>
+void write_instrumentation(ostream& out, int mcs, int since, const HopProbe<D, G>& probe, PhaseProfiler& profiler) {
+    long long acc = 0, rej = probe.skipped_attempts;
+    for (size_t k = 0; k < probe.accepted.size(); ++k) { acc += probe.accepted[k]; rej += probe.rejected[k]; }
+    out << "{\"mcs\": " << mcs << ", \"since\": " << since << ", \"attempts\": " << acc + rej
+        << ", \"accepted\": " << acc << ", \"msd\": " << setprecision(15) << probe.msd() << setprecision(6) << ", \"displacement\": [";
+    for (int a = 0; a < D; ++a) out << (a ? ", " : "") << probe.displacement[a];
+    out << "], \"de\": {";
+    bool first = true;
+    for (size_t k = 0; k < probe.accepted.size(); ++k) {
+        if (probe.accepted[k] == 0 && probe.rejected[k] == 0) continue;
+        out << (first ? "" : ", ") << "\"" << (int)k - probe.max_de << "\": [" << probe.accepted[k] << ", " << probe.rejected[k] << "]";
+        first = false;
+    }
+    out << "}, \"skipped\": " << probe.skipped_attempts << ", \"phases\": " << profiler.json() << "}\n";
+}
+
+// 不插桩: 不写任何内容
+inline void write_instrumentation(ostream&, int, int, const NullProbe&, PhaseProfiler&) {}
+
+#endif
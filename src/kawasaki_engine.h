@@ -0,0 +1,270 @@
+#ifndef KAWASAKI_ENGINE_H
+#define KAWASAKI_ENGINE_H
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <string>
+#include <cstdint>
+#include "vacancy_engine.h"
+
+using namespace std;
+
+// 满晶格初始化 (无空位): 50% A / 50% B 随机排列
+template <class Lat, class URBG>
+void fill_full_alloy(const Lat& lat, vector<int>& sites, URBG& g) {
+    int N = lat.sites();
+    sites.assign(N, -1);
+    fill(sites.begin(), sites.begin() + N / 2, 1);
+    shuffle_range(sites.begin(), sites.end(), g);
+}
+
+// Kawasaki (最近邻自旋交换) 动力学, 与 VacancyEngine 接口相同, 供 simulate.cpp 统一调度.
+// 物理与 baseline/kawasaki_dynamic.cpp 相同 (满晶格 50% A / 50% B, 每 MCS N 次交换尝试),
+// 改用 Lattice<D, L> 与整数 ΔE 查表: 交换相邻的异种原子 s 与 -s 时
+//   de = 2 s (R_i - R_j),   R_x 为 x 除对方以外 z-1 个邻居的自旋和,
+// de ∈ [-4(z-1), 4(z-1)], 同种原子对不改变构型, 不计算能量.
+template <int D, int CL = 0, class G = HyperCubic<D>>
+class KawasakiEngine {
+public:
+    using lattice_type = Lattice<D, CL, G>;
+    using Coord = typename lattice_type::Coord;
+
+    lattice_type lat;
+    vector<int> sites;
+    int v_pos = -1;       // 没有空位
+    long long energy = 0; // 以 J 为单位
+    double T, J;
+    MetropolisTable table;
+
+    KawasakiEngine(int L, double T_, double J_)
+        : lat(L), T(T_), J(J_), table(lattice_type::z, T_, J_, 4 * (lattice_type::z - 1)) {}
+
+    int size() const { return lat.size(); }
+    int sites_count() const { return lat.sites(); }
+
+    template <class URBG>
+    void initialize(URBG& g) {
+        fill_full_alloy(lat, sites, g);
+        energy = total_energy_bonds(lat, sites);
+    }
+
+    template <class URBG>
+    void sweep(long long n_attempts, URBG& g) {
+        const uint64_t N = lat.sites();
+        for (long long step = 0; step < n_attempts; ++step) {
+            int i = static_cast<int>((static_cast<uint64_t>(static_cast<uint32_t>(g())) * N) >> 32);
+            int dir = static_cast<int>((static_cast<uint64_t>(static_cast<uint32_t>(g())) * lattice_type::z) >> 32);
+            Coord c = lat.coords(i);
+            int j = lat.neighbor(c, i, dir);
+            int s = sites[i];
+            if (s == sites[j]) continue;
+            Coord cj = c;
+            lat.advance(cj, dir);
+            // 邻居和各含对方一次: R_i - R_j = (S_i + s) - (S_j - s)
+            int de = 2 * s * (lat.neighbor_sum(sites, c, i) - lat.neighbor_sum(sites, cj, j) + 2 * s);
+            if (table.accept(de, g)) {
+                sites[i] = -s;
+                sites[j] = s;
+                energy += de;
+            }
+        }
+    }
+
+    template <class URBG>
+    void mcs(URBG& g) { sweep(lat.sites(), g); }
+
+    double R_energy() const { return energy_domain_size(lat, energy); }
+    vector<double> correlation() const { return axial_correlation(lat, sites); }
+    void save_lattice(const string& filename) const { write_lattice(lat, sites, filename); }
+};
+
+// 按类别分组的键集合: 每条键至多属于一个类别, O(1) 插入 / 删除 / 按下标取出.
+// slot[b] 为键 b 在其类别列表中的位置, cls[b] = -1 表示不属于任何类别
+class BondClasses {
+public:
+    vector<vector<int>> items;
+
+    void reset(int n_classes, long long n_bonds) {
+        items.assign(n_classes, {});
+        slot.assign(n_bonds, 0);
+        cls.assign(n_bonds, -1);
+    }
+
+    inline void set(int b, int c) {
+        int old = cls[b];
+        if (old == c) return;
+        if (old >= 0) {
+            vector<int>& v = items[old];
+            int last = v.back();
+            v[slot[b]] = last;
+            slot[last] = slot[b];
+            v.pop_back();
+        }
+        if (c >= 0) {
+            slot[b] = (int)items[c].size();
+            items[c].push_back(b);
+        }
+        cls[b] = (int8_t)c;
+    }
+
+    long long total() const {
+        long long n = 0;
+        for (const auto& v : items) n += v.size();
+        return n;
+    }
+
+private:
+    vector<int> slot;
+    vector<int8_t> cls;
+};
+
+// 界面键列表版 Kawasaki 动力学: 与 KawasakiEngine 是同一个离散时间马尔可夫链, 但只从异种原子键中抽样.
+// 一次尝试 (随机格点 + 随机方向) 等价于在全部 N z/2 条无向键中均匀选一条, 落在同种原子键上的尝试不改变构型.
+// 设界面键共 M 条:
+//   列表模式: 到下一次选中界面键为止的尝试次数 K ~ Geometric(M / (N z/2)), 再在界面键中均匀选一条做 Metropolis 判定;
+//   无拒绝模式 (rejection_free): 界面键按 de = 2 s (R_i - R_j) 分类 (de 为 4 的倍数, 共 2(z-1)+1 类),
+//     第 c 类有 n_c 条、接受率 p_c, 一次尝试被接受的概率 P = Σ n_c p_c / (N z/2); K ~ Geometric(P),
+//     按 n_c p_c 选类、类内均匀选键, 交换必定执行.
+// 与 vacancy_sweep_rejection_free 相同, K 超出剩余尝试数时本段其余尝试全部无效, 采样网格 t = 2^n 不变.
+// 键编号 b = i * z/2 + k (格点 i 与其 +v_k 方向邻居之间的键, 超立方时 v_k 即第 k 轴). 一次交换后列表模式只需更新 i, j 上的 2z - 1 条键;
+// 无拒绝模式还要对 i, j 的邻居上的键重新分类 (它们的 R 变了), 2D 约 40 条, 3D 约 80 条.
+template <int D, int CL = 0, class G = HyperCubic<D>>
+class KawasakiBondEngine {
+public:
+    using lattice_type = Lattice<D, CL, G>;
+    using Coord = typename lattice_type::Coord;
+    static constexpr int z = lattice_type::z;
+    static constexpr int B = lattice_type::bond_dirs;
+
+    lattice_type lat;
+    vector<int> sites;
+    int v_pos = -1;       // 没有空位
+    long long energy = 0; // 以 J 为单位
+    double T, J;
+    MetropolisTable table;
+    bool rejection_free = false; // 切换后在下一次 sweep 时重建键集合 (O(N))
+
+    KawasakiBondEngine(int L, double T_, double J_)
+        : lat(L), T(T_), J(J_), table(z, T_, J_, 4 * (z - 1)) {}
+
+    int size() const { return lat.size(); }
+    int sites_count() const { return lat.sites(); }
+
+    template <class URBG>
+    void initialize(URBG& g) {
+        fill_full_alloy(lat, sites, g);
+        energy = total_energy_bonds(lat, sites);
+        built = false;
+    }
+
+    // 当前的界面键数 M
+    long long interface_bonds() {
+        if (!built || built_rf != rejection_free) rebuild();
+        return bonds.total();
+    }
+
+    template <class URBG>
+    void sweep(long long n_attempts, URBG& g) {
+        if (!built || built_rf != rejection_free) rebuild();
+        const double n_bonds = (double)lat.sites() * B;
+        const int n_classes = (int)bonds.items.size();
+        double weight[2 * (z - 1) + 1];
+        long long remaining = n_attempts;
+        while (remaining > 0) {
+            // 1. 一次尝试有效 (选中界面键 / 被接受) 的概率
+            double P = 0.0;
+            for (int c = 0; c < n_classes; ++c) {
+                weight[c] = bonds.items[c].size() * rate[c];
+                P += weight[c];
+            }
+            if (P <= 0.0) break; // 没有界面键 (或全部接受率为 0): 构型不再改变
+            P /= n_bonds;
+
+            // 2. 有效尝试之前的无效尝试一次跳过
+            long long K = geometric_attempts(P, remaining, g);
+            if (K > remaining) break;
+            remaining -= K;
+
+            // 3. 选键
+            int c = 0;
+            if (n_classes > 1) {
+                double x = uniform53(g) * P * n_bonds;
+                while (c < n_classes - 1 && (x >= weight[c] || bonds.items[c].empty())) { x -= weight[c]; ++c; }
+            }
+            const vector<int>& list = bonds.items[c];
+            int b = list[uniform_below(g, (uint32_t)list.size())];
+
+            int i = b / B, k = b % B;
+            Coord ci = lat.coords(i), cj = lat.move(ci, 2 * k);
+            int j = lat.index(cj);
+            int s = sites[i];
+            int de = 2 * s * (lat.neighbor_sum(sites, ci, i) - lat.neighbor_sum(sites, cj, j) + 2 * s);
+            if (!rejection_free && !table.accept(de, g)) continue;
+
+            // 4. 交换并更新键集合
+            sites[i] = -s;
+            sites[j] = s;
+            energy += de;
+            refresh_site(i, ci);
+            refresh_site(j, cj);
+            if (rejection_free) {
+                for (int dir = 0; dir < z; ++dir) {
+                    Coord cn = lat.move(ci, dir);
+                    refresh_site(lat.index(cn), cn);
+                    cn = lat.move(cj, dir);
+                    refresh_site(lat.index(cn), cn);
+                }
+            }
+        }
+    }
+
+    template <class URBG>
+    void mcs(URBG& g) { sweep(lat.sites(), g); }
+
+    double R_energy() const { return energy_domain_size(lat, energy); }
+    vector<double> correlation() const { return axial_correlation(lat, sites); }
+    void save_lattice(const string& filename) const { write_lattice(lat, sites, filename); }
+
+private:
+    BondClasses bonds;
+    vector<double> rate; // 各类的接受率 (列表模式只有一类, 判定在抽到之后做, 记 1)
+    bool built = false, built_rf = false;
+
+    // 键所属的类别: -1 为同种原子键
+    int bond_class(int i, const Coord& ci, int k) const {
+        Coord cj = lat.move(ci, 2 * k);
+        int j = lat.index(cj);
+        int s = sites[i];
+        if (s == sites[j]) return -1;
+        if (!rejection_free) return 0;
+        int de = 2 * s * (lat.neighbor_sum(sites, ci, i) - lat.neighbor_sum(sites, cj, j) + 2 * s);
+        return de / 4 + (z - 1);
+    }
+
+    // 格点 n 上的 z 条键: 以 n 为起点的 z/2 条, 以 n 的 -v_k 邻居为起点的 z/2 条
+    void refresh_site(int n, const Coord& cn) {
+        for (int k = 0; k < B; ++k) {
+            bonds.set(n * B + k, bond_class(n, cn, k));
+            Coord cm = lat.move(cn, 2 * k + 1);
+            int m = lat.index(cm);
+            bonds.set(m * B + k, bond_class(m, cm, k));
+        }
+    }
+
+    void rebuild() {
+        int n_classes = rejection_free ? 2 * (z - 1) + 1 : 1;
+        bonds.reset(n_classes, (long long)lat.sites() * B);
+        rate.assign(n_classes, 1.0);
+        if (rejection_free) {
+            for (int c = 0; c < n_classes; ++c) rate[c] = table.probability(4 * (c - (z - 1)));
+        }
+        for_each_site(lat, [&](int i, const Coord& ci) {
+            for (int k = 0; k < B; ++k) bonds.set(i * B + k, bond_class(i, ci, k));
+        });
+        built = true;
+        built_rf = rejection_free;
+    }
+};
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef LATTICE_H
+#define LATTICE_H
+
+#include <array>
+#include <cassert>
+#include "geometry.h"
+
+using namespace std;
+
+// 编译期判断 2 的幂
+constexpr bool is_pow2(int n) { return n > 0 && (n & (n - 1)) == 0; }
+constexpr int log2_int(int n) { return n <= 1 ? 0 : 1 + log2_int(n / 2); }
+
+// 格点在内存中的顺序 (Lattice 的第四个模板参数)
+//   RowMajor: 行优先, 2D: x*L + y,   3D: x*L^2 + y*L + z  (与 get_idx / get_idx_3d 一致)
+//   Morton:   Z 序, 坐标的第 j 位放在索引的第 D*j + (D-1-a) 位 (a = 0 为最高位, 与行优先同向);
+//             每个对齐的 2^k 立方块 (任意 k) 在内存中连续, 沿任何轴跳一步通常仍在同一页内.
+//             要求 L 为 2 的幂; 邻居由膨胀整数加减直接在索引上计算, 不需要坐标与乘法
+struct RowMajor { static constexpr bool row_major = true; };
+struct Morton { static constexpr bool row_major = false; };
+
+// D 维周期晶格, 索引顺序见上 (O)
+// CL > 0 时边长为编译期常量; CL 为 2 的幂时周期边界用位掩码实现,
+// CL = 0 为运行期 L 的后备版本 (用比较代替 %)
+// G 为几何 (geometry.h): 默认超立方 (2D 正方 / 3D 简单立方), 方向编号 dir = 2*axis + (0: +1, 1: -1);
+// 三角 / BCC / FCC 的键方向来自编译期偏移表, 前 D 个方向仍是坐标轴
+// 索引按轴可分: index(c) = Σ_a offset(a, c[a]), 两种顺序下都成立 (平移表、遍历与测量依赖这一点)
+template <int D, int CL = 0, class G = HyperCubic<D>, class O = RowMajor>
+class Lattice {
+public:
+    static_assert(G::dim == D, "geometry dimension mismatch");
+    static_assert(D == 2 || D == 3, "Morton 位交错只实现了 2D / 3D");
+    using geometry = G;
+    using order = O;
+    using row_major_type = Lattice<D, CL, G, RowMajor>; // 同一晶格的行优先版本 (快照与只支持行优先的测量模块)
+    static constexpr int dim = D;
+    static constexpr int z = G::z; // 配位数
+    static constexpr int bond_dirs = z / 2; // 每个格点作为 +v_k 起点的键数, 键总数 N * z / 2
+    static constexpr bool static_size = CL > 0;
+    static constexpr bool static_pow2 = is_pow2(CL);
+    static constexpr bool row_major = O::row_major;
+    using Coord = array<int, D>;
+
+    explicit Lattice(int L_ = CL) : L(static_size ? CL : L_) {
+        assert(L > 0 && (!static_size || L_ == CL));
+        assert(row_major || is_pow2(L));
+        int s = 1;
+        for (int a = D - 1; a >= 0; --a) { strides[a] = s; s *= L; }
+        N = s;
+        if constexpr (!O::row_major) for (int a = 0; a < D; ++a) masks[a] = axis_mask(a, L);
+    }
+
+    inline int size() const { return static_size ? CL : L; }
+    inline int sites() const { return static_size ? ipow(CL, D) : N; }
+
+    // 第 a 轴的步长 (编译期边长时为常量); 只对行优先顺序有意义
+    inline int stride(int a) const {
+        static_assert(O::row_major, "stride() 只对行优先顺序有意义, Morton 顺序用 offset() / neighbor()");
+        if constexpr (static_size) return ipow(CL, D - 1 - a);
+        else return strides[a];
+    }
+
+    // 周期性边界下坐标 +1 / -1, 无除法
+    inline int up(int c) const {
+        if constexpr (static_pow2) return (c + 1) & (CL - 1);
+        else { int n = c + 1; return n == size() ? 0 : n; }
+    }
+    inline int down(int c) const {
+        if constexpr (static_pow2) return (c - 1) & (CL - 1);
+        else return c == 0 ? size() - 1 : c - 1;
+    }
+    inline int step(int c, int dir) const { return (dir & 1) ? down(c) : up(c); }
+
+    // 第 a 轴坐标 x 对索引的贡献: 行优先为 x * stride(a), Morton 为 x 的膨胀整数
+    inline int offset(int a, int x) const {
+        if constexpr (O::row_major) return x * stride(a);
+        else return (int)(dilate(x) << (D - 1 - a));
+    }
+
+    inline int index(const Coord& c) const {
+        int i = 0;
+        for (int a = 0; a < D; ++a) i += offset(a, c[a]);
+        return i;
+    }
+
+    // 仅在初始化和测量时使用; 2 的幂时为移位与掩码
+    inline Coord coords(int i) const {
+        Coord c;
+        if constexpr (!O::row_major) {
+            for (int a = 0; a < D; ++a) c[a] = compact((unsigned)i >> (D - 1 - a));
+            return c;
+        }
+        for (int a = D - 1; a >= 0; --a) {
+            if constexpr (static_pow2) { c[a] = i & (CL - 1); i >>= log2_int(CL); }
+            else { c[a] = i % size(); i /= size(); }
+        }
+        return c;
+    }
+
+    // 同一格点在行优先顺序下的索引 (快照、检查点中的空位位置)
+    inline int row_major_index(int i) const {
+        if constexpr (O::row_major) return i;
+        else return row_major_type(size()).index(coords(i));
+    }
+
+    // 坐标 c 沿 dir 方向原地移动一步 (热路径用原地版本: 按值返回的 move 在跳跃核中会多出寄存器搬运)
+    inline void advance(Coord& c, int dir) const {
+        if constexpr (G::axial) {
+            c[dir >> 1] = step(c[dir >> 1], dir);
+        } else {
+            for (int a = 0; a < D; ++a) {
+                int v = G::bond(dir >> 1, a);
+                if (v) c[a] = (v > 0) != (dir & 1) ? up(c[a]) : down(c[a]);
+            }
+        }
+    }
+
+    inline Coord move(Coord c, int dir) const {
+        advance(c, dir);
+        return c;
+    }
+
+    // 坐标为 c、索引为 i 的格点沿 dir 方向的邻居索引 (Morton 顺序只用 i)
+    inline int neighbor(const Coord& c, int i, int dir) const {
+        if constexpr (!O::row_major) {
+            if constexpr (G::axial) {
+                return dilated_step(i, dir >> 1, dir & 1);
+            } else {
+                for (int a = 0; a < D; ++a) {
+                    int v = G::bond(dir >> 1, a);
+                    if (v) i = dilated_step(i, a, (v > 0) == (dir & 1));
+                }
+                return i;
+            }
+        } else if constexpr (G::axial) {
+            int a = dir >> 1;
+            return i + (step(c[a], dir) - c[a]) * stride(a);
+        } else {
+            for (int a = 0; a < D; ++a) {
+                int v = G::bond(dir >> 1, a);
+                if (v) i += (((v > 0) != (dir & 1) ? up(c[a]) : down(c[a])) - c[a]) * stride(a);
+            }
+            return i;
+        }
+    }
+
+    // 对 z 个邻居求和 (循环在编译期展开)
+    template <class Sites>
+    inline int neighbor_sum(const Sites& s, const Coord& c, int i) const {
+        int sum = 0;
+        for (int dir = 0; dir < z; ++dir) sum += s[neighbor(c, i, dir)];
+        return sum;
+    }
+
+private:
+    static constexpr int ipow(int b, int e) { return e == 0 ? 1 : b * ipow(b, e - 1); }
+
+    // 膨胀整数: x 的第 j 位移到第 D*j 位 (2D 每轴至多 16 位, 3D 至多 10 位), compact 为其逆
+    static constexpr unsigned dilate(unsigned x) {
+        if constexpr (D == 2) {
+            x = (x | (x << 8)) & 0x00FF00FFu;
+            x = (x | (x << 4)) & 0x0F0F0F0Fu;
+            x = (x | (x << 2)) & 0x33333333u;
+            return (x | (x << 1)) & 0x55555555u;
+        } else {
+            x = (x | (x << 16)) & 0x030000FFu;
+            x = (x | (x << 8)) & 0x0300F00Fu;
+            x = (x | (x << 4)) & 0x030C30C3u;
+            return (x | (x << 2)) & 0x09249249u;
+        }
+    }
+    static constexpr int compact(unsigned x) {
+        if constexpr (D == 2) {
+            x &= 0x55555555u;
+            x = (x | (x >> 1)) & 0x33333333u;
+            x = (x | (x >> 2)) & 0x0F0F0F0Fu;
+            x = (x | (x >> 4)) & 0x00FF00FFu;
+            return (int)((x | (x >> 8)) & 0x0000FFFFu);
+        } else {
+            x &= 0x09249249u;
+            x = (x | (x >> 2)) & 0x030C30C3u;
+            x = (x | (x >> 4)) & 0x0300F00Fu;
+            x = (x | (x >> 8)) & 0xFF0000FFu;
+            return (int)((x | (x >> 16)) & 0x000003FFu);
+        }
+    }
+    // 第 a 轴坐标在 Morton 索引中占的位 (只取 N 以内的位, 周期边界由溢出位被掩掉自动实现)
+    static constexpr unsigned axis_mask(int a, int L) { return dilate((unsigned)L - 1) << (D - 1 - a); }
+
+    // Morton 索引 i 的第 a 轴坐标 +1 (down = 0) 或 -1 (down = 1): 其他轴的位填 1 让进位穿过, 借位同理
+    inline int dilated_step(int i, int a, int down) const {
+        unsigned m;
+        if constexpr (static_size) m = axis_mask(a, CL);
+        else m = masks[a];
+        unsigned u = (unsigned)i;
+        unsigned t = down ? (u & m) - 1 : (u | ~m) + 1;
+        return (int)((t & m) | (u & ~m));
+    }
+
+    int L;
+    int N = 1;
+    array<int, D> strides{};
+    array<unsigned, D> masks{};
+};
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef LIVE_VIEW_H
+#define LIVE_VIEW_H
+
+#include <string>
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "vacancy_engine.h"
+#include "packed_sites.h"
+
+using namespace std;
+
+// 共享内存实时视图: 运行中的模拟把晶格、空位位置、能量与 MCS 计数发布到 POSIX 共享内存段
+// (/dev/shm/<name>), 读取端 (live_view.py) 直接 mmap, 不经过文件, 也不阻塞模拟.
+// 段名由驱动程序带上进程号, 保证并发运行互不干扰; 同名段已存在时不覆盖, 只关闭实时视图.
+//
+// 段布局 (小端序, 全部 8 字节对齐):
+//   段头 128 字节    LiveHeader
+//   两个缓冲区       LiveFrame (64 字节) + words 个 uint64 位图, 位序与 pack_sites / 轨迹文件相同,
+//                    始终按行优先顺序 (Morton 引擎发布时转换), 空位处的位为 0
+// 写端只写非 current 的缓冲区: seq 置奇数 -> 写数据 -> seq 置偶数, 再把 current 指向它 (seqlock + 双缓冲).
+// 读端读 current 缓冲区, 前后两次读到相同的偶数 seq 才算一致, 否则重试; 写端从不等待读端.
+//
+// 读端每次读取时写入 reader_heartbeat (Unix 毫秒), 并可写入 reader_interval 请求更细的发布间隔.
+// 心跳超过 heartbeat_timeout 未更新即视为无读者: 此时每个 MCS 只多一次时间比较, 不做任何拷贝.
+
+const char live_view_magic[8] = {'V', 'M', 'D', 'L', 'I', 'V', 'E', '1'};
+const uint64_t heartbeat_timeout_ms = 2000;
+
+struct LiveHeader {
+    char magic[8];
+    uint32_t version, dim, L, pad;
+    double T, J;
+    uint64_t n_sites, words;      // words: 每个缓冲区的位图字数
+    uint64_t frame_offset[2];     // 两个缓冲区相对段首的字节偏移
+    uint64_t current;             // 最近一次发布的缓冲区 (0/1)
+    uint64_t frames;              // 已发布帧数
+    uint64_t reader_heartbeat;    // 读端写入: Unix 毫秒
+    uint64_t reader_interval;     // 读端写入: 发布间隔 (跳跃尝试数), 0 为每 MCS 一次
+    int64_t writer_pid;
+    uint64_t reserved[2];
+};
+static_assert(sizeof(LiveHeader) == 128, "live view header layout");
+
+struct LiveFrame {
+    uint64_t seq;        // seqlock 序号, 奇数表示正在写
+    uint64_t mcs;        // 与输出文件相同的 MCS 标号
+    uint64_t attempt;    // 该 MCS 内已完成的尝试数, N 为整个 MCS 完成 (即 t = mcs 的构型)
+    int64_t vacancy;     // 空位的行优先索引
+    int64_t energy;      // 以 J 为单位的整数能量
+    double R_energy;
+    uint64_t reserved[2];
+};
+static_assert(sizeof(LiveFrame) == 64, "live view frame layout");
+
+inline uint64_t unix_ms() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+class LiveView {
+public:
+    // enabled = false 或同名段已存在时不创建共享内存段, attached() 恒为 false
+    template <class Lat>
+    LiveView(bool enabled, const string& name_, const Lat& lat, double T, double J) : name(name_) {
+        if (!enabled) return;
+        uint64_t N = lat.sites(), words = (N + 63) / 64;
+        frame_bytes = sizeof(LiveFrame) + words * 8;
+        bytes = sizeof(LiveHeader) + 2 * frame_bytes;
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0 && errno == EEXIST) {
+            cerr << "Warning: shared memory " << name << " already exists (another run?), live view disabled" << endl;
+            return;
+        }
+        if (fd < 0 || ftruncate(fd, bytes) != 0) {
+            cerr << "Warning: cannot create shared memory " << name << ", live view disabled" << endl;
+            if (fd >= 0) { close(fd); shm_unlink(name.c_str()); }
+            return;
+        }
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) {
+            cerr << "Warning: cannot map shared memory " << name << ", live view disabled" << endl;
+            shm_unlink(name.c_str());
+            return;
+        }
+        base = (char*)p;
+        memset(base, 0, bytes);
+        LiveHeader& h = header();
+        h.version = 1; h.dim = Lat::dim; h.L = lat.size();
+        h.T = T; h.J = J;
+        h.n_sites = N; h.words = words;
+        h.frame_offset[0] = sizeof(LiveHeader);
+        h.frame_offset[1] = sizeof(LiveHeader) + frame_bytes;
+        h.writer_pid = getpid();
+        // magic 最后写入: 读端看到 magic 时其余字段已就绪
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        memcpy(h.magic, live_view_magic, 8);
+        cout << "Live view: /dev/shm" << name << " (python live_view.py " << name.substr(1) << ")" << endl;
+    }
+
+    ~LiveView() {
+        if (!base) return;
+        munmap(base, bytes);
+        shm_unlink(name.c_str()); // 只有创建者到这里; 已映射的读端仍可读最后一帧
+    }
+
+    LiveView(const LiveView&) = delete;
+    LiveView& operator=(const LiveView&) = delete;
+
+    bool enabled() const { return base != nullptr; }
+
+    // 读端心跳未过期
+    bool attached() const {
+        if (!base) return false;
+        uint64_t beat = __atomic_load_n(&header().reader_heartbeat, __ATOMIC_RELAXED);
+        return beat != 0 && unix_ms() < beat + heartbeat_timeout_ms;
+    }
+
+    // 一个 MCS: 无读者时 sweep(N) 一次推进; 有读者时按读端请求的间隔分段推进, 每段后发布一帧.
+    // 分段只用于 Metropolis 核 (逐位相同). 无拒绝核与快进核每次调用按剩余尝试数重新抽取等待时间 /
+    // 快进半径, 分段会改变随机数用量与轨迹, 此时 splittable = false, 只在 MCS 末尾发布, 读者不影响模拟
+    template <class Engine, class Sweep>
+    void mcs(const Engine& e, long long mcs_label, Sweep&& sweep, bool splittable = true) {
+        const long long N = e.lat.sites();
+        if (!attached()) {
+            sweep(N);
+            return;
+        }
+        uint64_t req = splittable ? __atomic_load_n(&header().reader_interval, __ATOMIC_RELAXED) : 0;
+        long long chunk = req == 0 ? N : (long long)min<uint64_t>(req, N);
+        for (long long done = 0; done < N;) {
+            long long n = min(chunk, N - done);
+            sweep(n);
+            done += n;
+            publish(e, mcs_label, done);
+        }
+    }
+
+    // 把引擎当前状态写入非 current 缓冲区并切换 current
+    template <class Engine>
+    void publish(const Engine& e, long long mcs_label, long long attempt) {
+        if (!base) return;
+        LiveHeader& h = header();
+        uint64_t b = h.current ^ 1; // 只有写端修改 current
+        LiveFrame& f = frame(b);
+        uint64_t seq = f.seq + 1;
+        __atomic_store_n(&f.seq, seq, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        f.mcs = mcs_label;
+        f.attempt = attempt;
+        f.vacancy = e.lat.row_major_index(e.v_pos);
+        f.energy = e.energy;
+        f.R_energy = e.R_energy();
+        pack_into(e.lat, e.sites, bits(b));
+        __atomic_store_n(&f.seq, seq + 1, __ATOMIC_RELEASE);
+        __atomic_store_n(&h.current, b, __ATOMIC_RELEASE);
+        __atomic_store_n(&h.frames, h.frames + 1, __ATOMIC_RELAXED);
+    }
+
+private:
+    string name;
+    char* base = nullptr;
+    size_t bytes = 0, frame_bytes = 0;
+
+    LiveHeader& header() const { return *(LiveHeader*)base; }
+    LiveFrame& frame(uint64_t b) const { return *(LiveFrame*)(base + header().frame_offset[b]); }
+    uint64_t* bits(uint64_t b) const { return (uint64_t*)(base + header().frame_offset[b] + sizeof(LiveFrame)); }
+
+    // 直接写入共享内存, 逐字组装后整字写出; 行优先的 PackedSites 整段拷贝
+    template <class Lat, class Sites>
+    static void pack_into(const Lat& lat, const Sites& sites, uint64_t* out) {
+        if constexpr (is_same_v<Sites, PackedSites>) {
+            if constexpr (Lat::row_major) {
+                memcpy(out, sites.words.data(), sites.words.size() * 8);
+                return;
+            }
+        }
+        uint64_t word = 0;
+        int bit = 0;
+        for_each_site(lat, [&](int i, const typename Lat::Coord&) {
+            word |= (uint64_t)(sites[i] > 0) << bit;
+            if (++bit == 64) { *out++ = word; word = 0; bit = 0; }
+        });
+        if (bit) *out = word;
+    }
+};
+
+#endif
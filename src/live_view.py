@@ -0,0 +1,133 @@
+import os
+import sys
+import glob
+import time
+import argparse
+import numpy as np
+
+# 读取运行中模拟发布到共享内存的实时视图 (C++ 端见 live_view.h)
+# 用法: python live_view.py [vmd_live_2d | vmd_live_2d_<pid>] [--interval=尝试数] [--monitor]
+# 段在 /dev/shm/<name>_<pid> (驱动程序启动时打印), 以 numpy.memmap 映射; 读取时写入心跳, 模拟只在有心跳时才发布帧
+
+HEADER = np.dtype([('magic', 'S8'), ('version', '<u4'), ('dim', '<u4'), ('L', '<u4'), ('pad', '<u4'),
+                   ('T', '<f8'), ('J', '<f8'), ('n_sites', '<u8'), ('words', '<u8'), ('frame_offset', '<u8', 2),
+                   ('current', '<u8'), ('frames', '<u8'), ('reader_heartbeat', '<u8'), ('reader_interval', '<u8'),
+                   ('writer_pid', '<i8'), ('reserved', '<u8', 2)])
+FRAME = np.dtype([('seq', '<u8'), ('mcs', '<u8'), ('attempt', '<u8'), ('vacancy', '<i8'),
+                  ('energy', '<i8'), ('R_energy', '<f8'), ('reserved', '<u8', 2)])
+
+
+def find_segment(name):
+    """完整段名直接使用; 否则取以 name_ 开头的最新段 (不带进程号时即最近启动的运行)"""
+    path = os.path.join('/dev/shm', name.lstrip('/'))
+    if os.path.exists(path):
+        return path
+    candidates = glob.glob(path + '_*')
+    if not candidates:
+        raise FileNotFoundError(path)
+    return max(candidates, key=os.path.getmtime)
+
+
+class LiveView:
+    def __init__(self, name='vmd_live_2d', interval=0):
+        path = find_segment(name)
+        self.data = np.memmap(path, dtype=np.uint8, mode='r+')
+        self.header = self.data[:HEADER.itemsize].view(HEADER)
+        h = self.header[0]
+        if h['magic'] != b'VMDLIVE1':
+            raise ValueError(f"不是实时视图段: {path}")
+        self.dim, self.L = int(h['dim']), int(h['L'])
+        self.T, self.J = float(h['T']), float(h['J'])
+        self.n_sites, words = int(h['n_sites']), int(h['words'])
+        self.shape = (self.L,) * self.dim
+        self.pid = int(h['writer_pid'])
+        self.frames, self.bits = [], []
+        for off in h['frame_offset']:
+            off = int(off)
+            self.frames.append(self.data[off:off + FRAME.itemsize].view(FRAME))
+            self.bits.append(self.data[off + FRAME.itemsize:off + FRAME.itemsize + 8 * words])
+        self.header['reader_interval'] = interval
+        self.heartbeat()
+
+    def heartbeat(self):
+        self.header['reader_heartbeat'] = int(time.time() * 1000)
+
+    def writer_alive(self):
+        try:
+            os.kill(self.pid, 0)
+            return True
+        except ProcessLookupError:
+            return False
+        except PermissionError:
+            return True
+
+    def snapshot(self, timeout=5.0):
+        """最近一帧: dict(mcs, attempt, vacancy, energy, R_energy, lattice); 超时返回 None.
+        lattice 为形状 (L,)*D 的 int8 数组, A = +1, B = -1, 空位 = 0.
+        seqlock 读取: 前后两次 seq 相同且为偶数才接受 (x86 上读与读不重排, numpy 拷贝即可)"""
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            self.heartbeat()
+            if self.header[0]['frames'] == 0:
+                time.sleep(0.01)
+                continue
+            b = int(self.header[0]['current'])
+            f = self.frames[b]
+            s1 = int(f[0]['seq'])
+            if s1 & 1:
+                continue
+            meta = f[0].copy()
+            payload = np.array(self.bits[b])
+            if int(f[0]['seq']) != s1:
+                continue  # 写端已改写该缓冲区, 重试
+            bits = np.unpackbits(payload, bitorder='little')[:self.n_sites]
+            lattice = 2 * bits.astype(np.int8) - 1
+            lattice[int(meta['vacancy'])] = 0
+            return {'mcs': int(meta['mcs']), 'attempt': int(meta['attempt']), 'vacancy': int(meta['vacancy']),
+                    'energy': int(meta['energy']), 'R_energy': float(meta['R_energy']),
+                    'lattice': lattice.reshape(self.shape)}
+        return None
+
+
+def monitor(view, period):
+    while view.writer_alive():
+        s = view.snapshot()
+        if s is None:
+            print("等待帧...")
+            continue
+        print(f"MCS {s['mcs']} + {s['attempt']}/{view.n_sites} | E = {s['energy']} J | R = {s['R_energy']:.3f} "
+              f"| 空位 {tuple(int(c) for c in np.unravel_index(s['vacancy'], view.shape))}")
+        time.sleep(period)
+
+
+def show(view, period):
+    import matplotlib.pyplot as plt
+    plt.ion()
+    fig, ax = plt.subplots(figsize=(6, 6))
+    image = None
+    while view.writer_alive() and plt.fignum_exists(fig.number):
+        s = view.snapshot()
+        if s is None:
+            continue
+        lattice = s['lattice'] if view.dim == 2 else s['lattice'][view.L // 2]  # 3D 显示中间截面
+        if image is None:
+            image = ax.imshow(lattice, cmap='coolwarm', vmin=-1, vmax=1, interpolation='nearest')
+        else:
+            image.set_data(lattice)
+        ax.set_title(f"MCS {s['mcs']}  R = {s['R_energy']:.2f}")
+        plt.pause(period)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument('name', nargs='?', default='vmd_live_2d')
+    parser.add_argument('--interval', type=int, default=0, help='发布间隔 (跳跃尝试数), 0 为每 MCS 一次; 无拒绝核与快进核总是每 MCS 一次')
+    parser.add_argument('--period', type=float, default=0.2, help='刷新周期 (秒)')
+    parser.add_argument('--monitor', action='store_true', help='只打印 MCS / 能量 / R, 不作图')
+    args = parser.parse_args()
+    try:
+        view = LiveView(args.name, args.interval)
+    except FileNotFoundError:
+        print(f"错误: 未找到 /dev/shm/{args.name.lstrip('/')}[_<pid>], 模拟未运行或未开启 live_view")
+        sys.exit(1)
+    (monitor if args.monitor else show)(view, args.period)
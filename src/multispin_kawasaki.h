@@ -0,0 +1,234 @@
+#ifndef MULTISPIN_KAWASAKI_H
+#define MULTISPIN_KAWASAKI_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "kawasaki_engine.h"
+
+using namespace std;
+
+// 多自旋编码 (multispin coding) 的 Kawasaki 动力学: 每个格点存 W 个 64 位字, 第 k 位是副本 k 在该格点的自旋
+// (1 = A/+1, 0 = B/-1), 一次交换尝试同时作用于全部 64 W 个副本.
+//
+// 交换 i 与其邻居 j 时, 设 a / b 为 i / j 除对方以外 z-1 个邻居中与自身同种的个数, 则
+//   de = 4 (a + b) - 4 (z-1),   c = a + b ∈ [0, 2(z-1)],
+// 与 KawasakiEngine 的 de = 2 s (R_i - R_j) 相同. 各副本的 c 用位切片加法器按位并行求出; c <= z-1 (de <= 0)
+// 的副本总是接受, 其余副本各有一个独立的 32 位均匀数 u, 接受条件 u < threshold[4(c-(z-1))] 与标量引擎相同.
+// u 按位平面从高位向低位逐个抽取 (每个平面 64 位 = 每个副本一位), 与各副本阈值的对应位按位比较,
+// 已分出大小的副本不再参与; 通常几个平面后全部副本都已判定. 接受掩码 = [i, j 异种] & [接受],
+// 交换即两个字各异或一次掩码.
+//
+// 副本共用 (格点, 方向) 序列, 接受判定的随机数彼此独立, 初始构型也各自独立; ensemble.h 把每个副本作为一个样本.
+//
+// W = 4 时按字的循环可被编译器展开成 AVX2 指令 (编译时加 -mavx2 或 -march=native), 每格点 256 个副本.
+#ifdef __AVX2__
+constexpr int multispin_words = 4;
+#else
+constexpr int multispin_words = 1;
+#endif
+
+// 按位计数器: 把许多个 W 字的掩码逐位累加 (位切片的行波进位计数器, 平均每次加法约 2 个平面),
+// counts()[k] 为第 k 位上 1 的总数
+template <int W>
+class BitCounter {
+public:
+    static constexpr int n_planes = 40;
+
+    BitCounter() : planes(n_planes * W, 0) {}
+
+    inline void add(const uint64_t* x) {
+        for (int w = 0; w < W; ++w) {
+            uint64_t carry = x[w];
+            for (int p = 0; carry; ++p) {
+                uint64_t& plane = planes[p * W + w];
+                uint64_t t = plane & carry;
+                plane ^= carry;
+                carry = t;
+            }
+        }
+    }
+
+    vector<long long> counts() const {
+        vector<long long> n(64 * W, 0);
+        for (int p = 0; p < n_planes; ++p) {
+            for (int w = 0; w < W; ++w) {
+                uint64_t plane = planes[p * W + w];
+                for (; plane; plane &= plane - 1) n[w * 64 + __builtin_ctzll(plane)] += 1LL << p;
+            }
+        }
+        return n;
+    }
+
+private:
+    vector<uint64_t> planes;
+};
+
+template <int D, int CL = 0, int W = multispin_words, class G = HyperCubic<D>>
+class MultispinKawasakiEngine {
+public:
+    using lattice_type = Lattice<D, CL, G>;
+    using Coord = typename lattice_type::Coord;
+    static constexpr int z = lattice_type::z;
+    static constexpr int replicas = 64 * W;
+    static constexpr int max_c = 2 * (z - 1);
+    static constexpr int count_bits = log2_int(max_c) + 1; // 位切片计数器的位数
+
+    static constexpr int hot_classes = max_c - (z - 1); // de > 0 的类别 c = z .. max_c
+
+    lattice_type lat;
+    vector<uint64_t> spins; // 格点 i 的字为 spins[i * W .. i * W + W)
+    double T, J;
+    MetropolisTable table;
+    uint32_t hot_threshold[hot_classes]; // 类别 z + k 的接受阈值
+
+    MultispinKawasakiEngine(int L, double T_, double J_)
+        : lat(L), T(T_), J(J_), table(z, T_, J_, 4 * (z - 1)) {
+        for (int k = 0; k < hot_classes; ++k) hot_threshold[k] = table.threshold[4 * (k + 1)];
+    }
+
+    int size() const { return lat.size(); }
+    int sites_count() const { return lat.sites(); }
+
+    // 各副本依次从 g 抽取独立的 50% A / 50% B 随机排列
+    template <class URBG>
+    void initialize(URBG& g) {
+        int N = lat.sites();
+        spins.assign((size_t)N * W, 0);
+        vector<int> sites;
+        for (int k = 0; k < replicas; ++k) {
+            fill_full_alloy(lat, sites, g);
+            uint64_t bit = 1ULL << (k & 63);
+            for (int i = 0; i < N; ++i) {
+                if (sites[i] > 0) spins[(size_t)i * W + (k >> 6)] |= bit;
+            }
+        }
+    }
+
+    template <class URBG>
+    void sweep(long long n_attempts, URBG& g) {
+        const uint64_t N = lat.sites();
+        int nb_i[z - 1], nb_j[z - 1];
+        for (long long step = 0; step < n_attempts; ++step) {
+            int i = static_cast<int>((static_cast<uint64_t>(static_cast<uint32_t>(g())) * N) >> 32);
+            int dir = static_cast<int>((static_cast<uint64_t>(static_cast<uint32_t>(g())) * z) >> 32);
+            Coord c = lat.coords(i);
+            int j = lat.neighbor(c, i, dir);
+            uint64_t* wi = &spins[(size_t)i * W];
+            uint64_t* wj = &spins[(size_t)j * W];
+
+            uint64_t any = 0;
+            for (int w = 0; w < W; ++w) any |= wi[w] ^ wj[w];
+            if (!any) continue; // 全部副本在此处都是同种原子对
+
+            Coord cj = lat.move(c, dir);
+            for (int d = 0, n = 0; d < z; ++d) if (d != dir) nb_i[n++] = lat.neighbor(c, i, d);
+            for (int d = 0, n = 0; d < z; ++d) if (d != (dir ^ 1)) nb_j[n++] = lat.neighbor(cj, j, d);
+
+            for (int w = 0; w < W; ++w) {
+                uint64_t diff = wi[w] ^ wj[w];
+                if (!diff) continue;
+                // 位切片计数 c = a + b (cb[b] 为各副本计数的第 b 位)
+                uint64_t cb[count_bits] = {};
+                auto add = [&](uint64_t x) {
+                    for (int b = 0; b < count_bits; ++b) {
+                        uint64_t carry = cb[b] & x;
+                        cb[b] ^= x;
+                        x = carry;
+                    }
+                };
+                for (int n = 0; n < z - 1; ++n) add(~(spins[(size_t)nb_i[n] * W + w] ^ wi[w]));
+                for (int n = 0; n < z - 1; ++n) add(~(spins[(size_t)nb_j[n] * W + w] ^ wj[w]));
+                // 各 de > 0 类别的副本掩码 cls[k] = [c == z + k]
+                uint64_t cls[hot_classes], hot = 0;
+                for (int k = 0; k < hot_classes; ++k) {
+                    uint64_t m = diff;
+                    for (int b = 0; b < count_bits; ++b) m &= ((z + k) >> b) & 1 ? cb[b] : ~cb[b];
+                    cls[k] = m;
+                    hot |= m;
+                }
+                // 每个 hot 副本的独立 u 与其阈值逐位比较 (高位在前): lt 为已判定 u < 阈值, open 为仍相等
+                uint64_t lt = 0, open = hot;
+                for (int b = 31; b >= 0 && open; --b) {
+                    uint64_t u = (static_cast<uint64_t>(static_cast<uint32_t>(g())) << 32) | static_cast<uint32_t>(g());
+                    uint64_t tb = 0;
+                    for (int k = 0; k < hot_classes; ++k) if ((hot_threshold[k] >> b) & 1) tb |= cls[k];
+                    lt |= open & ~u & tb;
+                    open &= ~(u ^ tb);
+                }
+                uint64_t m = (diff & ~hot) | lt;
+                wi[w] ^= m;
+                wj[w] ^= m;
+            }
+        }
+    }
+
+    template <class URBG>
+    void mcs(URBG& g) { sweep(lat.sites(), g); }
+
+    // 各副本沿全部坐标轴平移 r 的异种原子对数
+    vector<long long> unlike_pairs(int r) const {
+        BitCounter<W> counter;
+        int L = lat.size();
+        uint64_t x[W];
+        for (int a = 0; a < D; ++a) {
+            for_each_site(lat, [&](int i, const Coord& c) {
+                Coord cr = c;
+                cr[a] = (c[a] + r) % L;
+                const uint64_t* wi = &spins[(size_t)i * W];
+                const uint64_t* wr = &spins[(size_t)lat.index(cr) * W];
+                for (int w = 0; w < W; ++w) x[w] = wi[w] ^ wr[w];
+                counter.add(x);
+            });
+        }
+        return counter.counts();
+    }
+
+    // 各副本的总能量 (以 J 为单位): 全部 N z/2 条键中异类键 U, E = 2U - N z/2
+    vector<long long> energies() const {
+        BitCounter<W> counter;
+        uint64_t x[W];
+        for_each_site(lat, [&](int i, const Coord& c) {
+            const uint64_t* wi = &spins[(size_t)i * W];
+            for (int k = 0; k < lattice_type::bond_dirs; ++k) {
+                const uint64_t* wj = &spins[(size_t)lat.neighbor(c, i, 2 * k) * W];
+                for (int w = 0; w < W; ++w) x[w] = wi[w] ^ wj[w];
+                counter.add(x);
+            }
+        });
+        vector<long long> U = counter.counts();
+        long long bonds = (long long)lat.sites() * lattice_type::bond_dirs;
+        for (long long& u : U) u = 2 * u - bonds;
+        return U;
+    }
+
+    vector<double> R_energies() const {
+        vector<long long> E = energies();
+        vector<double> R(replicas);
+        for (int k = 0; k < replicas; ++k) R[k] = energy_domain_size(lat, E[k]);
+        return R;
+    }
+
+    // 各副本的 C(r), r = 0..L/2 (与 axial_correlation 相同的定义): C[k][r]
+    vector<vector<double>> correlations() const {
+        int max_r = lat.size() / 2;
+        long long pairs = (long long)lat.sites() * D;
+        vector<vector<double>> C(replicas, vector<double>(max_r + 1, 1.0));
+        for (int r = 1; r <= max_r; ++r) {
+            vector<long long> U = unlike_pairs(r);
+            for (int k = 0; k < replicas; ++k) C[k][r] = (double)(pairs - 2 * U[k]) / pairs;
+        }
+        return C;
+    }
+
+    // 副本 k 的 -1/+1 构型 (用于 S(k)、快照)
+    vector<int> replica_sites(int k) const {
+        vector<int> sites(lat.sites());
+        for (int i = 0; i < lat.sites(); ++i) sites[i] = ((spins[(size_t)i * W + (k >> 6)] >> (k & 63)) & 1) ? 1 : -1;
+        return sites;
+    }
+
+    void save_lattice(int k, const string& filename) const { write_lattice(lat, replica_sites(k), filename); }
+};
+
+#endif
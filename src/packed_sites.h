@@ -0,0 +1,117 @@
+#ifndef PACKED_SITES_H
+#define PACKED_SITES_H
+
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// 位压缩格点存储: 每个格点 1 位记录原子种类 (1 = A/+1, 0 = B/-1),
+// 唯一的空位坐标单独保存 (空位处的位恒为 0).
+// 3D L=256 仅需 2 MB (vector<int> 为 64 MB), L=1024 为 128 MB.
+// operator[] 返回与 vector<int> 相同的 -1/0/+1, 跳跃核可直接读取.
+class PackedSites {
+public:
+    vector<uint64_t> words;
+    int vacancy = -1;
+
+    void assign(int n) {
+        n_sites = n;
+        words.assign((n + 63) / 64, 0);
+        vacancy = -1;
+    }
+
+    int size() const { return n_sites; }
+
+    inline int bit(int i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+
+    inline void set_bit(int i, int b) {
+        uint64_t m = 1ULL << (i & 63);
+        words[i >> 6] = (words[i >> 6] & ~m) | (-(uint64_t)b & m);
+    }
+
+    // 无分支: 空位处掩码为 0
+    inline int operator[](int i) const {
+        return (2 * bit(i) - 1) & -(int)(i != vacancy);
+    }
+
+private:
+    int n_sites = 0;
+};
+
+// 被接受的跳跃: 原子 spin 从 from 移入空位 to, from 成为新空位
+inline void move_atom(vector<int>& sites, int from, int to, int spin) {
+    sites[to] = spin;
+    sites[from] = 0;
+}
+
+inline void move_atom(PackedSites& sites, int from, int to, int spin) {
+    sites.set_bit(to, spin > 0);
+    sites.set_bit(from, 0);
+    sites.vacancy = from;
+}
+
+// 软件预取格点 i 所在的缓存行 (只读, 见 interleaved.h)
+inline void prefetch_site(const vector<int>& sites, int i) { __builtin_prefetch(&sites[i], 0, 3); }
+inline void prefetch_site(const PackedSites& sites, int i) { __builtin_prefetch(&sites.words[i >> 6], 0, 3); }
+
+// 沿第 a 轴平移 r 的所有格点对 (i, i + r e_a) 中种类位不同的对数 (含空位处的位).
+// 要求行优先布局且 L 为 64 的倍数: 非最后一轴的步长是整字, 直接对字异或;
+// 最后一轴每行 L/64 个字, 用漏斗移位拼出平移后的字. 每 64 对一次 popcount.
+template <class Lat>
+long long packed_unlike_pairs(const Lat& lat, const PackedSites& s, int a, int r) {
+    const int L = lat.size();
+    const long long W = s.words.size();
+    const uint64_t* w = s.words.data();
+    long long unlike = 0;
+    if (a < Lat::dim - 1) {
+        long long ws = lat.offset(a, 1) / 64; // 一步对应的字数
+        long long block = ws * L;          // 沿 a 轴一个周期的字数
+        long long shift = (long long)r * ws;
+        for (long long base = 0; base < W; base += block) {
+            const uint64_t* b = w + base;
+            for (long long k = 0; k < block - shift; ++k) unlike += __builtin_popcountll(b[k] ^ b[k + shift]);
+            for (long long k = block - shift; k < block; ++k) unlike += __builtin_popcountll(b[k] ^ b[k + shift - block]);
+        }
+    } else {
+        int R = L / 64;
+        int q = r / 64, sh = r % 64;
+        for (long long base = 0; base < W; base += R) {
+            const uint64_t* row = w + base;
+            for (int k = 0; k < R; ++k) {
+                int k1 = k + q;     if (k1 >= R) k1 -= R;
+                int k2 = k1 + 1;    if (k2 >= R) k2 -= R;
+                uint64_t shifted = sh ? (row[k1] >> sh) | (row[k2] << (64 - sh)) : row[k1];
+                unlike += __builtin_popcountll(row[k] ^ shifted);
+            }
+        }
+    }
+    return unlike;
+}
+
+// 任意存储 -> 每格点 1 位 (1 = A); 检查点 (checkpoint.h) 与轨迹文件 (trajectory.h) 共用
+template <class Sites>
+vector<uint64_t> pack_sites(const Sites& sites, int N) {
+    vector<uint64_t> words((N + 63) / 64, 0);
+    for (int i = 0; i < N; ++i) words[i >> 6] |= (uint64_t)(sites[i] > 0) << (i & 63);
+    return words;
+}
+inline vector<uint64_t> pack_sites(const PackedSites& sites, int) { return sites.words; }
+
+inline void unpack_sites(const vector<uint64_t>& words, int N, int v_pos, vector<int>& sites) {
+    sites.resize(N);
+    for (int i = 0; i < N; ++i) sites[i] = ((words[i >> 6] >> (i & 63)) & 1) ? 1 : -1;
+    if (v_pos >= 0) sites[v_pos] = 0; // v_pos < 0: 无空位 (Kawasaki)
+}
+inline void unpack_sites(const vector<uint64_t>& words, int N, int v_pos, PackedSites& sites) {
+    sites.assign(N);
+    sites.words = words;
+    if (v_pos >= 0) sites.set_bit(v_pos, 0);
+    sites.vacancy = v_pos;
+}
+
+// 按字平移的前提: 行优先顺序 (Morton 顺序走逐点扫描) 且 L 为 64 的倍数
+template <class Lat>
+inline bool packed_popcount_ok(const Lat& lat) { return Lat::row_major && lat.size() % 64 == 0; }
+
+#endif
@@ -0,0 +1,179 @@
+#ifndef PARALLEL_ENGINE_H
+#define PARALLEL_ENGINE_H
+
+#include <vector>
+#include <random>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include "vacancy_engine.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+// 区域分解的并行空位动力学 (稀疏多空位, 用于 2D L >= 1024 / 3D L >= 256)
+//
+// 晶格每轴分成 nb 个边长 B = L/nb 的子区域 (nb 为偶数, B >= 2), 按各轴块坐标的奇偶性
+// 染成 2^D 种颜色. 每一轮先随机平移整个子区域网格, 再依次激活每种颜色:
+// 同色子区域之间至少隔一个完整的非激活子区域, 而空位只在自己的子区域内跳跃
+// (跨出边界的尝试按拒绝处理, 正反两个方向同样被拒绝, 细致平衡不变),
+// 读邻居最多越出边界一格, 因此并发跳跃不会触及同一条键. 每个空位有自己的随机数流,
+// 结果与线程数无关.
+//
+// 时间标度: 一个 MCS 内全部 M 个空位共尝试 N 次跳跃 (每个空位 N/M 次),
+// 与单空位动力学每 MCS 的 N 次尝试 (即 N 次可能的原子移动) 相对应, 两者的 R(t) 可直接比较.
+template <int D, int CL = 0>
+class ParallelVacancyEngine {
+public:
+    using lattice_type = Lattice<D, CL>;
+    using Coord = typename lattice_type::Coord;
+    static constexpr int n_colors = 1 << D;
+
+    lattice_type lat;
+    vector<int> sites;
+    vector<int> v_pos;
+    vector<Coord> vc;
+    vector<Rng> rng;          // 每个空位一个独立随机数流 (互不重叠的 xoshiro 子流)
+    long long energy = 0;     // 以 J 为单位
+    double T, J;
+    MetropolisTable table;
+
+    // n_vac: 空位数; nb: 每轴子区域数; rounds: 每 MCS 的平移轮数 (0 = 自动, 使每个阶段空位约走 B 步)
+    ParallelVacancyEngine(int L, double T_, double J_, int n_vac, int nb_, uint64_t seed, int rounds_ = 0)
+        : lat(L), T(T_), J(J_), table(lattice_type::z, T_, J_), nb(nb_), B(L / nb_),
+          master(make_master_stream(seed)) {
+        assert(nb % 2 == 0 && B >= 2 && B * nb == L);
+        v_pos.resize(n_vac);
+        vc.resize(n_vac);
+        StreamSplitter streams(seed);
+        rng.reserve(n_vac);
+        for (int k = 0; k < n_vac; ++k) rng.push_back(streams.next());
+        hops_per_vacancy = max(1LL, (long long)lat.sites() / n_vac);
+        rounds = rounds_ > 0 ? rounds_ : (int)max(1LL, hops_per_vacancy / ((long long)B * B));
+        n_blocks = 1;
+        for (int a = 0; a < D; ++a) n_blocks *= nb;
+        block_start.resize(n_blocks + 1);
+        order.resize(n_vac);
+        local.resize(n_vac);
+    }
+
+    int size() const { return lat.size(); }
+    int sites_count() const { return lat.sites(); }
+    int vacancies() const { return (int)v_pos.size(); }
+
+    // 50% A / 50% B 随机排列, 再在 M 个不同位置注入空位
+    void initialize() {
+        int N = lat.sites();
+        sites.assign(N, -1);
+        fill(sites.begin(), sites.begin() + N / 2, 1);
+        shuffle_range(sites.begin(), sites.end(), master);
+        for (int k = 0; k < vacancies();) {
+            int i = (int)uniform_below(master, N);
+            if (sites[i] == 0) continue;
+            sites[i] = 0;
+            v_pos[k] = i;
+            vc[k] = lat.coords(i);
+            ++k;
+        }
+        energy = total_energy_bonds(lat, sites);
+    }
+
+    void mcs(WorkerPool& pool) {
+        vector<long long> de_worker(pool.size());
+        for (int round = 0; round < rounds; ++round) {
+            long long attempts = hops_per_vacancy / rounds + (round < hops_per_vacancy % rounds);
+            assign_blocks();
+            // 颜色顺序每轮随机, 避免系统性偏差
+            array<int, n_colors> colors;
+            for (int c = 0; c < n_colors; ++c) colors[c] = c;
+            shuffle_range(colors.begin(), colors.end(), master);
+            for (int color : colors) {
+                atomic<int> next(0);
+                fill(de_worker.begin(), de_worker.end(), 0);
+                pool.run([&](int w) {
+                    for (int b; (b = next.fetch_add(1)) < n_blocks;) {
+                        if (block_color(b) != color) continue;
+                        for (int j = block_start[b]; j < block_start[b + 1]; ++j) {
+                            de_worker[w] += run_vacancy(order[j], attempts);
+                        }
+                    }
+                });
+                for (long long de : de_worker) energy += de;
+            }
+        }
+    }
+
+    double R_energy() const { return D / ((double)energy / lat.sites() + D); }
+    vector<double> correlation() const { return axial_correlation(lat, sites); }
+    void save_lattice(const string& filename) const { write_lattice(lat, sites, filename); }
+
+private:
+    int nb, B, n_blocks, rounds;
+    long long hops_per_vacancy;
+    Rng master;
+    Coord shift{};
+    vector<int> block_start, order;
+    vector<Coord> local;      // 空位在所属子区域内的局部坐标
+
+    int block_color(int b) const {
+        int color = 0;
+        for (int a = D - 1; a >= 0; --a) { color |= (b % nb & 1) << a; b /= nb; }
+        return color;
+    }
+
+    // 随机平移子区域网格, 按子区域对空位做计数排序
+    void assign_blocks() {
+        for (int a = 0; a < D; ++a) shift[a] = (int)uniform_below(master, lat.size());
+        vector<int> block_of(vacancies());
+        fill(block_start.begin(), block_start.end(), 0);
+        for (int k = 0; k < vacancies(); ++k) {
+            int b = 0;
+            for (int a = 0; a < D; ++a) {
+                int u = vc[k][a] - shift[a];
+                if (u < 0) u += lat.size();
+                b = b * nb + u / B;
+                local[k][a] = u % B;
+            }
+            block_of[k] = b;
+            block_start[b + 1]++;
+        }
+        for (int b = 0; b < n_blocks; ++b) block_start[b + 1] += block_start[b];
+        vector<int> fillp(block_start.begin(), block_start.end() - 1);
+        for (int k = 0; k < vacancies(); ++k) order[fillp[block_of[k]]++] = k;
+    }
+
+    // 空位 k 在其子区域内执行 attempts 次跳跃尝试
+    long long run_vacancy(int k, long long attempts) {
+        long long de_total = 0;
+        Rng& gen = rng[k];
+        Coord& c = vc[k];
+        Coord& loc = local[k];
+        int v = v_pos[k];
+        int v_sum = lat.neighbor_sum(sites, c, v);
+        for (long long step = 0; step < attempts; ++step) {
+            int dir = static_cast<int>((static_cast<uint64_t>(static_cast<uint32_t>(gen())) * lattice_type::z) >> 32);
+            int a = dir >> 1;
+            bool minus = dir & 1;
+            if (minus ? loc[a] == 0 : loc[a] == B - 1) continue; // 跨出子区域: 拒绝
+            int n_idx = lat.neighbor(c, v, dir);
+            int s = sites[n_idx];
+            if (s == 0) continue; // 与另一个空位交换不改变构型
+            Coord nc = c;
+            nc[a] = lat.step(c[a], dir);
+            int n_sum = lat.neighbor_sum(sites, nc, n_idx);
+            int de = s * (n_sum - v_sum) + 1;
+            if (table.accept(de, gen)) {
+                move_atom(sites, n_idx, v, s);
+                de_total += de;
+                v = n_idx;
+                c = nc;
+                loc[a] += minus ? -1 : 1;
+                v_sum = n_sum + s;
+            }
+        }
+        v_pos[k] = v;
+        return de_total;
+    }
+};
+
+#endif
@@ -1,44 +1,27 @@
 import numpy as np
 import matplotlib.pyplot as plt
-import glob
-import re
-from scipy.stats import linregress
+from summary import read_summary, fit_line
 
-def find_zero_crossing(r, c):
-    for i in range(len(c)-1):
-        if c[i] * c[i+1] <= 0:
-            return r[i] - c[i] * (r[i+1] - r[i]) / (c[i+1] - c[i])
-    return None
+# 数据来自 ./analyze ../output_3d --fit=100: (C++ 后处理, 见 analyze.cpp), 不再逐个读取 Cr_t_*.txt
 
 def plot_scaling_comparison():
-    # 获取能量数据
-    e_data = np.loadtxt('../output_3d/t_vs_R.txt')
-    t_e, R_e = e_data[:, 0], e_data[:, 1]
-
-    # 获取关联函数零点数据
-    cr_files = glob.glob('../output_3d/Cr_t_*.txt')
-    cr_files.sort(key=lambda x: int(re.search(r't_(\d+)\.txt', x).group(1)))
-    
-    t_c, R_c = [], []
-    for f in cr_files:
-        t_val = int(re.search(r't_(\d+)\.txt', f).group(1))
-        data = np.loadtxt(f)
-        z = find_zero_crossing(data[:, 0], data[:, 1])
-        if z:
-            t_c.append(t_val)
-            R_c.append(z)
+    series, fits = read_summary('../output_3d/summary.txt')
+    group = next(iter(series))
+    s = series[group]
+    t_e, R_e = s['t'], s['R_energy']
+    ok = ~np.isnan(s['R_zero'])
+    t_c, R_c = s['t'][ok], s['R_zero'][ok]
 
     plt.figure(figsize=(10, 6))
     plt.loglog(t_e[1:], R_e[1:], 'o-', label='R (Energy-based)')
     plt.loglog(t_c, R_c, 's--', label='R (C(r) zero-crossing)')
 
     # 线性拟合验证 1/3 指数
-    if len(t_e) > 5:
-        log_t = np.log10(t_e[t_e > 100])
-        log_r = np.log10(R_e[t_e > 100])
-        slope, intercept, _, _, _ = linregress(log_t, log_r)
-        plt.loglog(t_e[t_e > 100], 10**(slope * log_t + intercept), 'k--', 
-                   label=f'Fit slope: {slope:.3f} (Theory: 0.333)')
+    fit = next((f for f in fits if f['group'] == group and f['observable'] == 'R_energy'), None)
+    if fit:
+        t_fit = t_e[(t_e >= fit['t_min']) & (t_e <= fit['t_max'])]
+        plt.loglog(t_fit, fit_line(fit, t_fit), 'k--',
+                   label=f"Fit slope: {fit['slope']:.3f} (Theory: 0.333)")
 
     plt.xlabel('log(t)')
     plt.ylabel('log(R)')
@@ -49,4 +32,4 @@ def plot_scaling_comparison():
     plt.show()
 
 if __name__ == "__main__":
-    plot_scaling_comparison()
\ No newline at end of file
+    plot_scaling_comparison()
@@ -1,32 +1,30 @@
 import numpy as np
 import matplotlib.pyplot as plt
 import matplotlib.animation as animation
-import glob
-import re
 import os
+from trajectory import Trajectory
 
 def generate_lattice_gif():
-    # 1. 获取并按时间顺序排列所有晶格文件
-    files = glob.glob('../output/lattice_t_*.txt')
-    files.sort(key=lambda x: int(re.search(r't_(\d+)', x).group(1)))
-
-    if not files:
-        print("错误: 在 ../output/ 文件夹下未找到晶格数据文件。")
+    # 1. 打开二进制轨迹文件 (帧按时间顺序排列, 见 trajectory.py)
+    path = '../output/trajectory.bin'
+    if not os.path.exists(path):
+        print("错误: 在 ../output/ 文件夹下未找到轨迹文件 trajectory.bin。")
         return
+    traj = Trajectory(path)
 
     # 2. 设置绘图环境
     fig, ax = plt.subplots(figsize=(6, 6))
     
     # 初始化第一帧
-    initial_lattice = np.loadtxt(files[0])
-    im = ax.imshow(initial_lattice, cmap='coolwarm', interpolation='nearest')
-    title = ax.set_title(f"Lattice Evolution: t = {re.search(r't_(\d+)', files[0]).group(1)} MCS")
+    initial_lattice = traj.frame(0)
+    im = ax.imshow(initial_lattice, cmap='coolwarm', interpolation='nearest', vmin=-1, vmax=1)
+    title = ax.set_title(f"Lattice Evolution: t = {traj.times[0]} MCS")
     ax.axis('off')
 
-    def update(frame_file):
+    def update(k):
         # 读取新的一帧数据
-        lattice = np.loadtxt(frame_file)
-        t = re.search(r't_(\d+)', frame_file).group(1)
+        lattice = traj.frame(k)
+        t = traj.times[k]
         
         # 更新图像内容
         im.set_array(lattice)
@@ -34,8 +32,8 @@ def generate_lattice_gif():
         return [im, title]
 
     # 3. 创建动画
-    # frames 传入文件列表，interval 为帧间隔（毫秒）
-    ani = animation.FuncAnimation(fig, update, frames=files, interval=500, blit=True)
+    # frames 为帧编号，interval 为帧间隔（毫秒）
+    ani = animation.FuncAnimation(fig, update, frames=len(traj), interval=500, blit=True)
 
     # 4. 保存为 GIF (需要安装 pillow 库)
     output_path = '../output/lattice_evolution.gif'
@@ -2,33 +2,28 @@ import numpy as np
 import matplotlib.pyplot as plt
 from mpl_toolkits.mplot3d import Axes3D
 import matplotlib.animation as animation
-import glob
-import re
 import os
 import sys
+from trajectory import Trajectory
 
 # ===========================
 # 参数设置
 # ===========================
-L = 64            # 必须与 C++ 代码中的 L 一致
-INPUT_DIR = '../output_3d'
+INPUT_FILE = '../output_3d/trajectory.bin'  # L 等参数从文件头读取
 OUTPUT_GIF = '../output_3d/3d_evolution.gif'
 FPS = 2           # 每秒帧数，数值越小动图越慢
-SLICE_INDEX = L // 2  # 2D切片的位置（中间）
 # ===========================
 
 def generate_3d_gif():
-    # 1. 获取并排序文件
-    files = glob.glob(os.path.join(INPUT_DIR, 'lattice_3d_t_*.txt'))
-    print(f"找到的文件列表: {files}")
-    # 使用正则表达式提取时间步 t 进行数值排序
-    files.sort(key=lambda x: int(re.search(r't_(\d+)\.txt', x).group(1)))
-
-    if not files:
-        print(f"错误: 在 {INPUT_DIR}/ 中未找到数据文件。请先运行 C++ 模拟。")
+    # 1. 打开轨迹文件
+    if not os.path.exists(INPUT_FILE):
+        print(f"错误: 未找到 {INPUT_FILE}。请先运行 C++ 模拟。")
         sys.exit(1)
 
-    print(f"找到 {len(files)} 个数据文件，开始生成动画...")
+    traj = Trajectory(INPUT_FILE)
+    L = traj.L
+    SLICE_INDEX = L // 2  # 2D切片的位置（中间）
+    print(f"找到 {len(traj)} 帧 (L = {L})，开始生成动画...")
 
     # 2. 初始化画布 (只需设置一次)
     fig = plt.subplots(figsize=(12, 6))
@@ -38,7 +33,7 @@ def generate_3d_gif():
     # ---- 初始化 2D 切片视图 (左图) ----
     ax2d = fig[0].add_subplot(121)
     # 先读取第一帧数据用于初始化图像对象
-    first_data = np.loadtxt(files[0]).reshape((L, L, L))
+    first_data = traj.frame(0)
     # 使用固定颜色范围 vmin/vmax，确保颜色映射在整个动画中保持一致
     im2d = ax2d.imshow(first_data[SLICE_INDEX, :, :], cmap='coolwarm', vmin=-1, vmax=1)
     ax2d.set_title(f"2D Mid-Slice (Z={SLICE_INDEX})")
@@ -60,13 +55,11 @@ def generate_3d_gif():
 
     # 3. 定义动画更新函数
     def update(frame_idx):
-        current_file = files[frame_idx]
-        t_val = re.search(r't_(\d+)\.txt', current_file).group(1)
-        print(f"Processing frame {frame_idx+1}/{len(files)}: t = {t_val} MCS...")
+        t_val = traj.times[frame_idx]
+        print(f"Processing frame {frame_idx+1}/{len(traj)}: t = {t_val} MCS...")
 
-        # 读取并重构数据
-        data_flat = np.loadtxt(current_file)
-        lattice = data_flat.reshape((L, L, L))
+        # 读取数据 (形状已是 (L, L, L))
+        lattice = traj.frame(frame_idx)
 
         # ---- 更新 2D 视图 ----
         # 只需更新数据，无需重绘坐标轴
@@ -92,7 +85,7 @@ def generate_3d_gif():
 
     # 4. 创建并保存动画
     # interval 计算公式：1000ms / FPS
-    ani = animation.FuncAnimation(fig[0], update, frames=len(files), interval=1000/FPS, blit=False)
+    ani = animation.FuncAnimation(fig[0], update, frames=len(traj), interval=1000/FPS, blit=False)
     
     print(f"正在保存 GIF 到 {OUTPUT_GIF} (这可能需要几秒钟)...")
     # 需要安装 pillow: pip install pillow
@@ -0,0 +1,184 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <array>
+
+using namespace std;
+
+// 随机数层: 批量生成的 xoshiro256** (Blackman & Vigna) 与可复现的子流.
+//
+// BatchedRng 内部是 4 路独立的 xoshiro256** (状态按 [字][路] 存放, 生成循环可被编译器向量化),
+// 一次填满 batch 个 32 位随机数; 内核每次抽取只是一次数组读取和一个几乎总是不跳转的分支.
+// 对外满足 UniformRandomBitGenerator, result_type 与 mt19937 同为 32 位, 跳跃核、BKL 核与
+// 检查点的 << / >> 序列化都不需要改动, 驱动程序只需替换类型 (using Rng = BatchedRng).
+//
+// 子流: 基础种子经 splitmix64 展开为 xoshiro256** 状态; 第 k 条流的第 l 路从基础状态前进
+// (k * lanes + l) * 2^128 步 (jump), 各路、各流互不重叠. 主控流 (初始化、颜色顺序等) 用 long_jump
+// 前进 2^192 步, 与所有子流分开. 初始化使用的下标抽样 uniform_below / shuffle_range 只依赖
+// 32 位输出, 同一种子在任何平台、任何标准库上得到相同的构型.
+
+inline uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+inline uint64_t rotl64(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+// 单路 xoshiro256**, 用于播种与 jump
+struct Xoshiro256ss {
+    uint64_t s[4];
+
+    explicit Xoshiro256ss(uint64_t seed = 0) {
+        for (auto& w : s) w = splitmix64(seed);
+    }
+
+    uint64_t next() {
+        uint64_t r = rotl64(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0]; s[3] ^= s[1]; s[1] ^= s[2]; s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl64(s[3], 45);
+        return r;
+    }
+
+    void jump() { apply({0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL}); }
+    void long_jump() { apply({0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL}); }
+
+private:
+    void apply(const array<uint64_t, 4>& poly) {
+        uint64_t t[4] = {0, 0, 0, 0};
+        for (uint64_t p : poly) {
+            for (int b = 0; b < 64; ++b) {
+                if (p & (1ULL << b)) for (int k = 0; k < 4; ++k) t[k] ^= s[k];
+                next();
+            }
+        }
+        memcpy(s, t, sizeof(s));
+    }
+};
+
+class BatchedRng {
+public:
+    using result_type = uint32_t;
+    static constexpr int lanes = 4;
+    static constexpr int batch = 256; // 32 位随机数个数, 每路每批 batch / (2 lanes) 次迭代
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return 0xFFFFFFFFu; }
+
+    // 第 0 条子流
+    explicit BatchedRng(uint64_t seed = 0) : BatchedRng(Xoshiro256ss(seed)) {}
+
+    // 各路依次取 base, base + 2^128, base + 2 * 2^128, ...
+    explicit BatchedRng(Xoshiro256ss base) {
+        for (int l = 0; l < lanes; ++l) {
+            for (int w = 0; w < 4; ++w) s[w][l] = base.s[w];
+            base.jump();
+        }
+    }
+
+    inline result_type operator()() {
+        if (pos == batch) refill();
+        return buf[pos++];
+    }
+
+    // 序列化: 当前批次开始时的状态 + 批内位置, 读回时重新生成该批次 (续算逐位相同);
+    // 批次已用完 (或尚未生成) 时直接写当前状态
+    friend ostream& operator<<(ostream& out, const BatchedRng& g) {
+        const uint64_t (*state)[lanes] = g.pos == batch ? g.s : g.s_batch;
+        for (int w = 0; w < 4; ++w) for (int l = 0; l < lanes; ++l) out << state[w][l] << " ";
+        return out << g.pos;
+    }
+    friend istream& operator>>(istream& in, BatchedRng& g) {
+        for (int w = 0; w < 4; ++w) for (int l = 0; l < lanes; ++l) in >> g.s[w][l];
+        int p;
+        in >> p;
+        if (p < batch) g.refill();
+        g.pos = p;
+        return in;
+    }
+
+private:
+    uint64_t s[4][lanes];
+    uint64_t s_batch[4][lanes];
+    uint32_t buf[batch];
+    int pos = batch;
+
+    // 每路的 64 位输出拆成高、低两个 32 位数
+    void refill() {
+        memcpy(s_batch, s, sizeof(s));
+        for (int k = 0; k < batch / (2 * lanes); ++k) {
+            for (int l = 0; l < lanes; ++l) {
+                uint64_t r = rotl64(s[1][l] * 5, 7) * 9;
+                uint64_t t = s[1][l] << 17;
+                s[2][l] ^= s[0][l]; s[3][l] ^= s[1][l]; s[1][l] ^= s[2][l]; s[0][l] ^= s[3][l];
+                s[2][l] ^= t;
+                s[3][l] = rotl64(s[3][l], 45);
+                buf[2 * (k * lanes + l)] = (uint32_t)(r >> 32);
+                buf[2 * (k * lanes + l) + 1] = (uint32_t)r;
+            }
+        }
+        pos = 0;
+    }
+};
+
+// 驱动程序使用的随机数类型; 换成 mt19937 也能编译 (只是慢, 且检查点格式不同)
+using Rng = BatchedRng;
+const char* const rng_name = "xoshiro256**x4";
+
+// 依次切出互不重叠的子流: 第 k 次 next() 与 make_stream(seed, k) 相同, 但总代价是 O(k) 而不是 O(k^2)
+class StreamSplitter {
+public:
+    explicit StreamSplitter(uint64_t seed) : base(seed) {}
+
+    Rng next() {
+        Rng g(base);
+        for (int l = 0; l < Rng::lanes; ++l) base.jump();
+        return g;
+    }
+    void skip(uint64_t n) { for (uint64_t k = 0; k < n * Rng::lanes; ++k) base.jump(); }
+
+private:
+    Xoshiro256ss base;
+};
+
+// 由 (基础种子, 流编号) 构造独立、可复现的随机数流 (用于副本 / 多空位)
+inline Rng make_stream(uint64_t seed, uint32_t stream) {
+    StreamSplitter sp(seed);
+    sp.skip(stream);
+    return sp.next();
+}
+
+// 主控流: 与所有子流相距 2^192 步
+inline Rng make_master_stream(uint64_t seed) {
+    Xoshiro256ss base(seed);
+    base.long_jump();
+    return Rng(base);
+}
+
+// [0, n) 内的无偏整数 (Lemire 乘法-移位 + 拒绝), 不依赖标准库分布的实现
+template <class URBG>
+inline uint32_t uniform_below(URBG& g, uint32_t n) {
+    uint64_t m = (uint64_t)static_cast<uint32_t>(g()) * n;
+    if ((uint32_t)m < n) {
+        uint32_t threshold = (0u - n) % n;
+        while ((uint32_t)m < threshold) m = (uint64_t)static_cast<uint32_t>(g()) * n;
+    }
+    return (uint32_t)(m >> 32);
+}
+
+// Fisher-Yates 洗牌, 与 uniform_below 一样与平台无关 (std::shuffle 的抽样方式由标准库决定)
+template <class It, class URBG>
+void shuffle_range(It first, It last, URBG& g) {
+    for (uint32_t n = (uint32_t)(last - first); n > 1; --n) {
+        uint32_t k = uniform_below(g, n);
+        swap(first[n - 1], first[k]);
+    }
+}
+
+#endif
@@ -0,0 +1,166 @@
+#include "config.h"
+#include "kawasaki_engine.h"
+#include "structure_factor.h"
+#include "trajectory.h"
+#include "domains.h"
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <filesystem>
+#include <type_traits>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// 统一驱动程序: 参数来自配置文件 / 命令行, 不再需要为每个 (D, L, T) 重新编译.
+// 用法: ./simulate [配置文件 ...] [--key=value ...]   (键见 config.h 中的 expand_jobs)
+//   ./simulate --D=3 --T_over_Tc=0.2 --output=../output_3d/run_0.2
+//   ./simulate --dynamics=vacancy,kawasaki --D=2,3 --T_over_Tc=0.2,0.5,0.7 --replicas=4 --output=../output/sweep
+//   ./simulate --D=3 --geometry=cubic,bcc,fcc --T_over_Tc=0.5 --output=../output_3d/geometries
+// 扫描时任务按估计耗时从大到小排入工作池 (每核一个任务), 每个任务单线程运行并写入自己的目录:
+//   config.txt, t_vs_R.txt, t_vs_R_sk.txt, domains.txt, time_log.txt, trajectory.bin,
+//   Sk_t_X.txt, Cr_rad_t_X.txt, Cr_t_X.txt, domains_t_X.txt
+// 多个任务时另在 output 下写 jobs.txt (任务名, 估计耗时, 实际秒数)
+
+mutex print_mutex;
+
+template <int D, int CL, class S, class G>
+void configure(VacancyEngine<D, CL, S, G>& e, const Job& job) { e.rejection_free = job.rejection_free; }
+template <int D, int CL, class G>
+void configure(KawasakiBondEngine<D, CL, G>& e, const Job& job) { e.rejection_free = job.rejection_free; }
+
+// 运行一个任务, 返回墙钟秒数. 测量在主循环内同步进行 (扫描时各核都在跑任务, 没有空闲核给后台流水线)
+template <class Engine>
+double run_job(const Job& job, int labeler_threads, bool verbose) {
+    fs::create_directories(job.dir);
+    write_job_config(job, job.dir + "/config.txt");
+
+    Rng gen = make_stream(job.seed, job.stream);
+    Engine engine(job.L, job.T, job.J);
+    engine.initialize(gen);
+    configure(engine, job);
+    const int N = engine.sites_count();
+    const int n_vac = engine.v_pos >= 0 ? 1 : 0; // Kawasaki 没有空位
+
+    StructureFactor<typename Engine::lattice_type> sf(engine.lat);
+    DomainLabeler<typename Engine::lattice_type> labeler(engine.lat, labeler_threads);
+    ofstream r_file(job.dir + "/t_vs_R.txt");
+    ofstream sk_file(job.dir + "/t_vs_R_sk.txt");
+    ofstream domain_file(job.dir + "/domains.txt");
+    ofstream time_log(job.dir + "/time_log.txt");
+    TrajectoryWriter trajectory(job.dir + "/trajectory.bin", job.D, job.L, job.geometry, job.T, job.J, job.seed, job.compress_frames);
+
+    auto start = chrono::high_resolution_clock::now();
+    for (int mcs = 0; mcs <= job.num_mc; ++mcs) {
+        auto step_start = chrono::high_resolution_clock::now();
+        engine.mcs(gen);
+        double step_time = chrono::duration<double>(chrono::high_resolution_clock::now() - step_start).count();
+
+        if ((mcs > 0 && (mcs & (mcs - 1)) == 0) || mcs == 0 || mcs == job.num_mc) {
+            StructureData sd = sf.measure(engine.sites, n_vac);
+            r_file << mcs << "\t" << engine.R_energy() << "\n";
+            sk_file << mcs << "\t" << sd.R_zero << "\t" << sd.R_k << "\t" << sd.k_mean << "\n";
+            write_structure(sd, job.dir, mcs);
+            write_C_r(sd.C_axial, job.dir + "/Cr_t_" + to_string(mcs) + ".txt");
+            write_domains(labeler.measure(engine.sites), job.dir, mcs, domain_file);
+            trajectory.write_frame(mcs, engine.sites, engine.v_pos);
+            if (verbose) {
+                lock_guard<mutex> lock(print_mutex);
+                cout << job.name() << " MCS: " << mcs << " | " << step_time * 1e9 / N << " ns/attempt | R: " << engine.R_energy() << endl;
+            }
+        }
+        if (mcs % 1000 == 0) time_log << mcs << "\t" << step_time << "\t" << step_time * 1e9 / N << "\n";
+    }
+    return chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+}
+
+template <int D, int CL, class G>
+double run_job_dynamics(const Job& job, int labeler_threads, bool verbose) {
+    // Kawasaki 用界面键列表版 (与 KawasakiEngine 同一个马尔可夫链, 只在异种原子键上抽样)
+    if (job.dynamics == "kawasaki") return run_job<KawasakiBondEngine<D, CL, G>>(job, labeler_threads, verbose);
+    // 3D L >= 256 用位压缩存储 (与 binary_alloys_3d.cpp 的建议一致); 运行期边长 (CL = 0) 按 job.L 选择
+    if constexpr (D == 3) {
+        if (job.L >= 256) return run_job<VacancyEngine<D, CL, PackedSites, G>>(job, labeler_threads, verbose);
+    }
+    return run_job<VacancyEngine<D, CL, vector<int>, G>>(job, labeler_threads, verbose);
+}
+
+template <int D, int CL>
+double run_job_geometry(const Job& job, int labeler_threads, bool verbose) {
+    if constexpr (D == 2) {
+        if (job.geometry == "triangular") return run_job_dynamics<D, CL, Triangular>(job, labeler_threads, verbose);
+    } else {
+        if (job.geometry == "bcc") return run_job_dynamics<D, CL, BCC>(job, labeler_threads, verbose);
+        if (job.geometry == "fcc") return run_job_dynamics<D, CL, FCC>(job, labeler_threads, verbose);
+    }
+    return run_job_dynamics<D, CL, HyperCubic<D>>(job, labeler_threads, verbose);
+}
+
+// 常用的 2 的幂边长在编译期实例化 (位掩码边界), 其余 L 走运行期版本
+template <int D>
+double run_job_sized(const Job& job, int labeler_threads, bool verbose) {
+    switch (job.L) {
+    case 64: return run_job_geometry<D, 64>(job, labeler_threads, verbose);
+    case 128: return run_job_geometry<D, 128>(job, labeler_threads, verbose);
+    case 256: return run_job_geometry<D, 256>(job, labeler_threads, verbose);
+    default: return run_job_geometry<D, 0>(job, labeler_threads, verbose);
+    }
+}
+
+inline double run_any_job(const Job& job, int labeler_threads, bool verbose) {
+    return job.D == 2 ? run_job_sized<2>(job, labeler_threads, verbose) : run_job_sized<3>(job, labeler_threads, verbose);
+}
+
+int main(int argc, char** argv) {
+    Config cfg;
+    if (!cfg.parse_args(argc, argv)) return 1;
+    vector<Job> jobs = expand_jobs(cfg);
+    for (const Job& job : jobs) {
+        if ((job.dynamics != "vacancy" && job.dynamics != "kawasaki") || (job.D != 2 && job.D != 3) || job.L < 2 ||
+            !valid_geometry(job.geometry, job.D)) {
+            cerr << "无效的任务参数: " << job.name() << endl;
+            return 1;
+        }
+    }
+
+    // 最长处理时间优先 (LPT): 耗时最长的任务先开始, 尾部只剩短任务, 各核的结束时间接近
+    vector<int> order(jobs.size());
+    for (size_t k = 0; k < jobs.size(); ++k) order[k] = (int)k;
+    stable_sort(order.begin(), order.end(), [&](int a, int b) { return jobs[a].cost > jobs[b].cost; });
+
+    int hw = max(1u, thread::hardware_concurrency());
+    int n_workers = cfg.get("threads", 0LL) > 0 ? (int)cfg.get("threads", 0LL) : hw;
+    n_workers = min(n_workers, (int)jobs.size());
+    int labeler_threads = max(1, hw / n_workers); // 只有一个任务时畴标记可用全部核
+    bool verbose = jobs.size() == 1;
+    cout << jobs.size() << " job(s) on " << n_workers << " worker(s), seed = " << jobs[0].seed << endl;
+
+    vector<double> seconds(jobs.size(), 0.0);
+    atomic<int> next(0);
+    vector<thread> pool;
+    auto start = chrono::high_resolution_clock::now();
+    for (int w = 0; w < n_workers; ++w) {
+        pool.emplace_back([&]() {
+            for (int k; (k = next.fetch_add(1)) < (int)jobs.size();) {
+                const Job& job = jobs[order[k]];
+                seconds[order[k]] = run_any_job(job, labeler_threads, verbose);
+                lock_guard<mutex> lock(print_mutex);
+                cout << "Job " << job.name() << " done in " << seconds[order[k]] << " s -> " << job.dir << endl;
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+    double wall = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+    double busy = 0.0;
+    for (double s : seconds) busy += s;
+    if (jobs.size() > 1) {
+        ofstream summary(cfg.get("output", "../output/run") + "/jobs.txt");
+        summary << "# name\tcost\tseconds\n";
+        for (size_t k = 0; k < jobs.size(); ++k) summary << jobs[k].name() << "\t" << jobs[k].cost << "\t" << seconds[k] << "\n";
+    }
+    cout << "\nTotal wall time: " << wall << " s, job time: " << busy << " s, speedup: " << busy / wall
+         << " (" << n_workers << " workers)" << endl;
+    return 0;
+}
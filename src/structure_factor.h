@@ -0,0 +1,281 @@
+#ifndef STRUCTURE_FACTOR_H
+#define STRUCTURE_FACTOR_H
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <string>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "vacancy_engine.h"
+
+using namespace std;
+
+// 自包含的一维复数 FFT: n 为 2 的幂时用迭代基 2 算法,
+// 否则用 Bluestein (chirp-z) 转化为长度 m >= 2n-1 的 2 的幂卷积, 均为 O(n log n)
+class FFT1D {
+public:
+    explicit FFT1D(int n_ = 1) : n(n_) {
+        if (is_pow2(n)) {
+            init_radix2(n, rev, tw);
+        } else {
+            m = 1;
+            while (m < 2 * n - 1) m <<= 1;
+            init_radix2(m, rev, tw);
+            chirp.resize(n);
+            for (int k = 0; k < n; ++k) {
+                // k^2 对 2n 取模后再乘 π/n, 避免大 k 时的相位误差
+                long long k2 = (long long)k * k % (2LL * n);
+                chirp[k] = polar(1.0, M_PI * k2 / n);
+            }
+            chirp_fft.assign(m, 0.0);
+            for (int k = 0; k < n; ++k) chirp_fft[k] = chirp[k];
+            for (int k = 1; k < n; ++k) chirp_fft[m - k] = chirp[k];
+            radix2(chirp_fft.data());
+            work.resize(m);
+        }
+    }
+
+    int size() const { return n; }
+
+    // 正变换 X_k = sum_j x_j exp(-2πi jk/n); inverse = true 时为不带 1/n 的逆变换
+    void transform(complex<double>* x, bool inverse = false) {
+        if (inverse) for (int j = 0; j < n; ++j) x[j] = conj(x[j]);
+        if (m == 0) {
+            radix2(x);
+        } else {
+            fill(work.begin(), work.end(), 0.0);
+            for (int j = 0; j < n; ++j) work[j] = x[j] * conj(chirp[j]);
+            radix2(work.data());
+            for (int j = 0; j < m; ++j) work[j] *= chirp_fft[j];
+            // 逆变换 = conj(FFT(conj(.))) / m
+            for (int j = 0; j < m; ++j) work[j] = conj(work[j]);
+            radix2(work.data());
+            for (int k = 0; k < n; ++k) x[k] = conj(work[k]) / (double)m * conj(chirp[k]);
+        }
+        if (inverse) for (int j = 0; j < n; ++j) x[j] = conj(x[j]);
+    }
+
+private:
+    int n, m = 0;
+    vector<int> rev;
+    vector<complex<double>> tw, chirp, chirp_fft, work;
+
+    static void init_radix2(int size, vector<int>& rev, vector<complex<double>>& tw) {
+        int bits = log2_int(size);
+        rev.assign(size, 0);
+        for (int i = 0; i < size; ++i) rev[i] = (rev[i >> 1] >> 1) | ((i & 1) << (bits - 1));
+        tw.resize(size / 2 + 1);
+        for (int i = 0; i < (int)tw.size(); ++i) tw[i] = polar(1.0, -2.0 * M_PI * i / size);
+    }
+
+    void radix2(complex<double>* x) const {
+        int size = (int)rev.size();
+        if (size <= 1) return;
+        for (int i = 0; i < size; ++i) if (i < rev[i]) swap(x[i], x[rev[i]]);
+        for (int len = 2; len <= size; len <<= 1) {
+            int half = len >> 1, step = size / len;
+            for (int i = 0; i < size; i += len) {
+                for (int j = 0; j < half; ++j) {
+                    complex<double> u = x[i + j], v = x[i + j + half] * tw[j * step];
+                    x[i + j] = u + v;
+                    x[i + j + half] = u - v;
+                }
+            }
+        }
+    }
+};
+
+// 单次测量结果
+struct StructureData {
+    vector<double> C_axial;         // 兼容模式: 沿坐标轴的 C(r), 与 Cr_t_*.txt 格式相同
+    vector<double> r_radial, C_radial; // 球平均 C(r): 壳层平均距离与关联
+    vector<double> k_shell, S_k;    // 球平均结构因子 S(k), k = 2π|n|/L (斜交晶格按倒易度规)
+    double R_zero = 0.0;            // 球平均 C(r) 的第一个零点
+    double k_mean = 0.0;            // 一阶矩 k̄ = Σ k S(k) / Σ S(k)
+    double R_k = 0.0;               // 2π / k̄
+};
+
+// 通过线性插值寻找 C(r) 的第一个零点 (与 analyze_results.py 中 find_first_zero 相同); 无零点返回 0
+inline double first_zero(const vector<double>& r, const vector<double>& c) {
+    for (size_t i = 0; i + 1 < c.size(); ++i) {
+        if (c[i] * c[i + 1] <= 0) {
+            if (c[i + 1] == c[i]) return r[i];
+            return r[i] - c[i] * (r[i + 1] - r[i]) / (c[i + 1] - c[i]);
+        }
+    }
+    return 0.0;
+}
+
+// 基于 FFT 的 O(N log N) 测量模块: 完整自关联函数 G(r) = IFFT(|FFT(s)|^2),
+// 由它得到球平均 C(r)、轴向 C(r) (兼容模式) 和球平均结构因子 S(k, t).
+// 工作区在多次测量间复用
+template <class Lat>
+class StructureFactor {
+    static_assert(Lat::row_major, "FFT 工作区按行优先排列; Morton 顺序的构型先用 to_row_major 转换");
+public:
+    explicit StructureFactor(const Lat& lat_) : lat(lat_), fft(lat_.size()), field(lat_.sites()), line(lat_.size()) {
+        int L = lat.size();
+        n_shells = L / 2 + 1;
+        shell.resize(lat.sites());
+        shell_count.assign(n_shells, 0);
+        shell_r.assign(n_shells, 0.0);
+        if constexpr (Lat::geometry::axial) {
+            // 每轴的最小镜像距离平方; 波矢 |n| 与位移 |r| 的壳层相同
+            vector<int> dist2(L);
+            for (int c = 0; c < L; ++c) { int d = min(c, L - c); dist2[c] = d * d; }
+            for_each_site(lat, [&](int i, const typename Lat::Coord& c) {
+                int d2 = 0;
+                for (int a = 0; a < Lat::dim; ++a) d2 += dist2[c[a]];
+                add_to_shell(shell, shell_count, shell_r, i, sqrt((double)d2));
+            });
+            kshell = shell;
+            kshell_count = shell_count;
+            kshell_r = shell_r;
+        } else {
+            // 斜交基矢: 位移 |r|^2 = m^T g m, 波矢 |n|^2 = n^T g^{-1} n (k = 2π|n|/L), 均取 3^D 个周期像中最短者
+            double g[Lat::dim][Lat::dim], ginv[Lat::dim][Lat::dim];
+            for (int a = 0; a < Lat::dim; ++a) for (int b = 0; b < Lat::dim; ++b) g[a][b] = Lat::geometry::metric(a, b);
+            invert(g, ginv);
+            kshell.resize(lat.sites());
+            kshell_count.assign(n_shells, 0);
+            kshell_r.assign(n_shells, 0.0);
+            for_each_site(lat, [&](int i, const typename Lat::Coord& c) {
+                add_to_shell(shell, shell_count, shell_r, i, min_image_norm(c, g));
+                add_to_shell(kshell, kshell_count, kshell_r, i, min_image_norm(c, ginv));
+            });
+        }
+    }
+
+    // n_vac: 空位数; 多空位时非零对数取 N - 2*n_vac (忽略 O(n_vac^2/N) 的空位-空位对)
+    template <class Sites>
+    StructureData measure(const Sites& sites, int n_vac = 1) {
+        const int N = lat.sites(), L = lat.size();
+        for (int i = 0; i < N; ++i) field[i] = (double)sites[i];
+        transform_all(false);
+
+        StructureData out;
+        // 1. 球平均 S(k) = |F(k)|^2 / N, 不含 k = 0
+        vector<double> S(n_shells, 0.0);
+        for (int i = 1; i < N; ++i) {
+            double p = norm(field[i]) / N;
+            field[i] = p * N; // |F|^2, 留作自关联
+            if (kshell[i] > 0) S[kshell[i]] += p;
+        }
+        field[0] = norm(field[0]);
+        double num = 0.0, den = 0.0;
+        for (int b = 1; b < n_shells; ++b) {
+            if (kshell_count[b] == 0) continue;
+            double k = 2.0 * M_PI * (kshell_r[b] / kshell_count[b]) / L;
+            double s = S[b] / kshell_count[b];
+            out.k_shell.push_back(k);
+            out.S_k.push_back(s);
+            num += k * s;
+            den += s;
+        }
+        out.k_mean = den > 0 ? num / den : 0.0;
+        out.R_k = out.k_mean > 0 ? 2.0 * M_PI / out.k_mean : 0.0;
+
+        // 2. 自关联 G(r) = Σ_i s_i s_{i+r}; 只有一个空位时非零对数为 N - 2 (r != 0)
+        transform_all(true);
+        double pairs = N - 2.0 * n_vac;
+        vector<double> C(n_shells, 0.0);
+        for (int i = 0; i < N; ++i) if (shell[i] >= 0) C[shell[i]] += field[i].real() / N / pairs;
+        out.r_radial.push_back(0.0);
+        out.C_radial.push_back(1.0);
+        for (int b = 1; b < n_shells; ++b) {
+            if (shell_count[b] == 0) continue;
+            out.r_radial.push_back(shell_r[b] / shell_count[b]);
+            out.C_radial.push_back(C[b] / shell_count[b]);
+        }
+        out.R_zero = first_zero(out.r_radial, out.C_radial);
+
+        // 3. 兼容模式: 轴向 C(r) 直接取 G(r e_a), 与 calculate_C_r / calculate_C_r_3d 的定义一致
+        int max_r = L / 2;
+        out.C_axial.assign(max_r + 1, 0.0);
+        for (int r = 1; r <= max_r; ++r) {
+            double sum = 0.0;
+            for (int a = 0; a < Lat::dim; ++a) sum += field[(long long)r * lat.stride(a)].real() / N;
+            out.C_axial[r] = sum / (pairs * Lat::dim);
+        }
+        out.C_axial[0] = 1.0;
+        return out;
+    }
+
+private:
+    Lat lat;
+    FFT1D fft;
+    vector<complex<double>> field, line;
+    vector<int> shell, kshell;         // 格点 -> 位移壳层 / 波矢壳层 (-1: 舍去)
+    vector<long long> shell_count, kshell_count;
+    vector<double> shell_r, kshell_r;
+    int n_shells;
+
+    void add_to_shell(vector<int>& sh, vector<long long>& count, vector<double>& sum_r, int i, double r) {
+        int b = (int)(r + 0.5);
+        sh[i] = b < n_shells ? b : -1; // 角落处 |r| > L/2 的壳层不完整, 舍去
+        if (sh[i] >= 0) { count[b]++; sum_r[b] += r; }
+    }
+
+    // sqrt(min_s (c + L s)^T m (c + L s)), s ∈ {-1, 0}^D (c 的分量在 [0, L) 内)
+    double min_image_norm(const typename Lat::Coord& c, const double (&m)[Lat::dim][Lat::dim]) const {
+        const int L = lat.size();
+        double best = -1.0;
+        for (int mask = 0; mask < (1 << Lat::dim); ++mask) {
+            double x[Lat::dim];
+            for (int a = 0; a < Lat::dim; ++a) x[a] = c[a] - ((mask >> a) & 1) * L;
+            double q = 0.0;
+            for (int a = 0; a < Lat::dim; ++a) for (int b = 0; b < Lat::dim; ++b) q += m[a][b] * x[a] * x[b];
+            if (best < 0 || q < best) best = q;
+        }
+        return sqrt(max(best, 0.0));
+    }
+
+    // D x D 矩阵求逆 (Gauss-Jordan, 度规正定)
+    static void invert(const double (&g)[Lat::dim][Lat::dim], double (&inv)[Lat::dim][Lat::dim]) {
+        constexpr int n = Lat::dim;
+        double a[n][2 * n];
+        for (int r = 0; r < n; ++r) for (int c = 0; c < 2 * n; ++c) a[r][c] = c < n ? g[r][c] : (c - n == r);
+        for (int p = 0; p < n; ++p) {
+            int best = p;
+            for (int r = p + 1; r < n; ++r) if (fabs(a[r][p]) > fabs(a[best][p])) best = r;
+            for (int c = 0; c < 2 * n; ++c) swap(a[p][c], a[best][c]);
+            double d = a[p][p];
+            for (int c = 0; c < 2 * n; ++c) a[p][c] /= d;
+            for (int r = 0; r < n; ++r) {
+                if (r == p) continue;
+                double f = a[r][p];
+                for (int c = 0; c < 2 * n; ++c) a[r][c] -= f * a[p][c];
+            }
+        }
+        for (int r = 0; r < n; ++r) for (int c = 0; c < n; ++c) inv[r][c] = a[r][c + n];
+    }
+
+    // D 维 FFT: 逐轴对每条线做一维变换
+    void transform_all(bool inverse) {
+        const int N = lat.sites(), L = lat.size();
+        for (int a = 0; a < Lat::dim; ++a) {
+            long long st = lat.stride(a);
+            long long block = st * L;
+            for (long long base = 0; base < N; base += block) {
+                for (long long off = 0; off < st; ++off) {
+                    complex<double>* p = field.data() + base + off;
+                    for (int c = 0; c < L; ++c) line[c] = p[c * st];
+                    fft.transform(line.data(), inverse);
+                    for (int c = 0; c < L; ++c) p[c * st] = line[c];
+                }
+            }
+        }
+    }
+};
+
+// 输出: Sk_t_X.txt 为 "k\tS(k)", Cr_rad_t_X.txt 为 "r\tC(r)" (球平均)
+inline void write_structure(const StructureData& d, const string& dir, int mcs) {
+    ofstream sk(dir + "/Sk_t_" + to_string(mcs) + ".txt");
+    for (size_t i = 0; i < d.S_k.size(); ++i) sk << fixed << setprecision(6) << d.k_shell[i] << "\t" << d.S_k[i] << "\n";
+    ofstream cr(dir + "/Cr_rad_t_" + to_string(mcs) + ".txt");
+    for (size_t i = 0; i < d.C_radial.size(); ++i) cr << fixed << setprecision(6) << d.r_radial[i] << "\t" << d.C_radial[i] << "\n";
+}
+
+#endif
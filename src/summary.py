@@ -0,0 +1,30 @@
+import numpy as np
+
+# 读取 C++ 端 analyze.cpp 写出的汇总文件 (summary.txt)
+#   series = read_summary(path)[0]: {组: {'t', 'n', 'R_energy', 'R_energy_err', 'R_zero', 'R_zero_err'}} (numpy 数组)
+#   fits   = read_summary(path)[1]: [{'group', 'observable', 't_min', 't_max', 'runs', 'slope', 'err', 'intercept'}]
+# 拟合线为 R = exp(intercept) * t^slope
+
+
+def read_summary(path):
+    rows, fits = {}, []
+    with open(path) as f:
+        for line in f:
+            if line.startswith('#'):
+                continue
+            p = line.rstrip('\n').split('\t')
+            if p[0] == 'series':
+                rows.setdefault(p[1], []).append([float(x) for x in p[2:8]])
+            elif p[0] == 'fit':
+                fits.append({'group': p[1], 'observable': p[2], 't_min': float(p[3]), 't_max': float(p[4]),
+                             'runs': int(p[5]), 'slope': float(p[6]), 'err': float(p[7]), 'intercept': float(p[8])})
+    series = {}
+    for group, values in rows.items():
+        a = np.array(values)
+        series[group] = {'t': a[:, 0], 'n': a[:, 1].astype(int), 'R_energy': a[:, 2], 'R_energy_err': a[:, 3],
+                         'R_zero': a[:, 4], 'R_zero_err': a[:, 5]}
+    return series, fits
+
+
+def fit_line(fit, t):
+    return np.exp(fit['intercept']) * np.asarray(t, dtype=float) ** fit['slope']
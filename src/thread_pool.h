@@ -0,0 +1,79 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+using namespace std;
+
+// 常驻工作线程池: run(f) 让每个线程执行一次 f(worker_id), 全部完成后返回.
+// 用于需要在每个 MCS 内多次同步的并行阶段, 避免反复创建线程
+class WorkerPool {
+public:
+    explicit WorkerPool(int n = 0) {
+        n_workers = n > 0 ? n : max(1u, thread::hardware_concurrency());
+        for (int w = 1; w < n_workers; ++w) threads.emplace_back([this, w] { loop(w); });
+    }
+
+    ~WorkerPool() {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+            ++generation;
+        }
+        cv_start.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    int size() const { return n_workers; }
+
+    // 调用线程作为 0 号工作线程参与执行
+    void run(const function<void(int)>& f) {
+        {
+            lock_guard<mutex> lock(m);
+            job = &f;
+            pending = n_workers - 1;
+            ++generation;
+        }
+        cv_start.notify_all();
+        f(0);
+        unique_lock<mutex> lock(m);
+        cv_done.wait(lock, [this] { return pending == 0; });
+        job = nullptr;
+    }
+
+private:
+    int n_workers;
+    vector<thread> threads;
+    mutex m;
+    condition_variable cv_start, cv_done;
+    const function<void(int)>* job = nullptr;
+    long long generation = 0;
+    int pending = 0;
+    bool stopping = false;
+
+    void loop(int w) {
+        long long seen = 0;
+        while (true) {
+            const function<void(int)>* f;
+            {
+                unique_lock<mutex> lock(m);
+                cv_start.wait(lock, [&] { return generation != seen; });
+                seen = generation;
+                if (stopping) return;
+                f = job;
+            }
+            (*f)(w);
+            {
+                lock_guard<mutex> lock(m);
+                if (--pending == 0) cv_done.notify_one();
+            }
+        }
+    }
+};
+
+#endif
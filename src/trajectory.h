@@ -0,0 +1,302 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <cstdint>
+#include <cstring>
+#include "packed_sites.h"
+#include "geometry.h"
+
+using namespace std;
+
+// 二进制轨迹文件: 取代逐格点 ASCII 的 lattice_t_*.txt 快照.
+// 每个采样时刻一帧, 每格点 1 位 (与检查点相同的 pack_sites 位序), 3D L=256 每帧 2 MB.
+//
+// 文件布局 (小端序; 帧数据从 8 字节对齐的偏移开始, Python 端可直接 numpy.memmap):
+//   文件头 64 字节   TrajectoryHeader
+//   帧记录           FrameHeader (32 字节) + bytes 字节数据 (补零到 8 的倍数)
+//                    encoding 0: 原始位图, (N+63)/64 个 uint64, 第 i 位为 1 表示格点 i 是 A 原子
+//                    encoding 1: 位图字节的游程编码 (rle_encode), 仅在更短时使用
+//   索引             {tag 'INDX', 0, n_frames} + n_frames 个 {mcs, 帧记录偏移}
+// 空位处的位为 0, 空位位置记录在帧头 (Kawasaki 轨迹为 -1). index_offset 在 close() 时回填;
+// 为 0 (程序被中断) 时读取端顺序扫描帧记录重建索引.
+// 版本 1 的文件没有几何编号, 按正方 / 简单立方读取.
+
+const char trajectory_magic[8] = {'V', 'M', 'D', 'T', 'R', 'A', 'J', '1'};
+const uint32_t frame_tag = 0x454D5246u; // "FRME"
+const uint32_t index_tag = 0x58444E49u; // "INDX"
+const uint32_t trajectory_version = 2;
+
+struct TrajectoryHeader {
+    char magic[8];
+    uint32_t version, dim, L, flags; // flags 第 0 位: 写入时启用压缩; 第 8-15 位: 几何编号 (版本 2 起, 见 geometry_id)
+    double T, J;
+    uint64_t seed, n_sites, index_offset;
+};
+static_assert(sizeof(TrajectoryHeader) == 64, "trajectory header layout");
+
+inline uint32_t trajectory_geometry(const TrajectoryHeader& h) { return h.version >= 2 ? (h.flags >> 8) & 0xFF : 0; }
+
+struct FrameHeader {
+    uint32_t tag, encoding;
+    uint64_t mcs;
+    int64_t vacancy;
+    uint64_t bytes;
+};
+static_assert(sizeof(FrameHeader) == 32, "frame header layout");
+
+// 字节游程编码: 控制字节 c < 128 后跟 c+1 个原样字节; c >= 128 表示下一字节重复 c-125 次 (3..130).
+// 畴粗化后位图中大段 0x00 / 0xFF 占多数, 无外部依赖
+inline vector<uint8_t> rle_encode(const uint8_t* p, size_t n) {
+    vector<uint8_t> out;
+    size_t i = 0;
+    while (i < n) {
+        size_t run = 1;
+        while (i + run < n && run < 130 && p[i + run] == p[i]) ++run;
+        if (run >= 3) {
+            out.push_back((uint8_t)(125 + run));
+            out.push_back(p[i]);
+            i += run;
+            continue;
+        }
+        size_t start = i, len = 0;
+        while (i < n && len < 128) {
+            if (i + 2 < n && p[i] == p[i + 1] && p[i] == p[i + 2]) break;
+            ++i; ++len;
+        }
+        out.push_back((uint8_t)(len - 1));
+        out.insert(out.end(), p + start, p + start + len);
+    }
+    return out;
+}
+
+inline bool rle_decode(const uint8_t* p, size_t n, uint8_t* out, size_t out_n) {
+    size_t i = 0, o = 0;
+    while (i < n) {
+        uint8_t c = p[i++];
+        if (c < 128) {
+            size_t len = c + 1;
+            if (i + len > n || o + len > out_n) return false;
+            memcpy(out + o, p + i, len);
+            i += len; o += len;
+        } else {
+            size_t len = c - 125;
+            if (i >= n || o + len > out_n) return false;
+            memset(out + o, p[i++], len);
+            o += len;
+        }
+    }
+    return o == out_n;
+}
+
+// 读取并校验文件头, 按索引 (或顺序扫描) 得到各帧的 mcs 与偏移;
+// end 返回最后一个完整帧记录之后的位置
+inline bool read_trajectory_index(istream& in, TrajectoryHeader& h, vector<uint64_t>& times,
+                                  vector<uint64_t>& offsets, uint64_t& end) {
+    in.clear();
+    in.seekg(0, ios::end);
+    uint64_t file_size = in.tellg();
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(&h), sizeof(h));
+    if (!in || memcmp(h.magic, trajectory_magic, 8) != 0) return false;
+    times.clear();
+    offsets.clear();
+
+    // 优先使用文件末尾的索引
+    if (h.index_offset >= sizeof(h) && h.index_offset + 16 <= file_size) {
+        uint32_t tag[2];
+        uint64_t n;
+        in.seekg(h.index_offset);
+        in.read(reinterpret_cast<char*>(tag), sizeof(tag));
+        in.read(reinterpret_cast<char*>(&n), sizeof(n));
+        if (in && tag[0] == index_tag && h.index_offset + 16 + 16 * n == file_size) {
+            times.resize(n);
+            offsets.resize(n);
+            for (uint64_t k = 0; k < n; ++k) {
+                uint64_t entry[2];
+                in.read(reinterpret_cast<char*>(entry), sizeof(entry));
+                times[k] = entry[0];
+                offsets[k] = entry[1];
+            }
+            end = h.index_offset;
+            return (bool)in;
+        }
+    }
+
+    // 没有完整索引: 顺序扫描帧记录, 在第一个不完整的记录处停止
+    uint64_t pos = sizeof(h);
+    FrameHeader f;
+    while (pos + sizeof(f) <= file_size) {
+        in.seekg(pos);
+        in.read(reinterpret_cast<char*>(&f), sizeof(f));
+        uint64_t next = pos + sizeof(f) + ((f.bytes + 7) & ~7ULL);
+        if (!in || f.tag != frame_tag || next > file_size) break;
+        times.push_back(f.mcs);
+        offsets.push_back(pos);
+        pos = next;
+    }
+    end = pos;
+    return true;
+}
+
+class TrajectoryWriter {
+public:
+    // append = true: 续算时打开已有文件 (load_checkpoint 已将其截断到检查点时刻),
+    // 保留原文件头 (包括种子) 与已有帧, 丢弃旧索引后继续追加.
+    // 文件无法读取、与当前参数不匹配或无法打开时 ok() 为 false, 调用方应在主循环之前中止
+    TrajectoryWriter(const string& path_, int dim, int L, const string& geometry, double T, double J, uint64_t seed,
+                     bool compress_ = false, bool append = false)
+        : path(path_), compress(compress_) {
+        memcpy(h.magic, trajectory_magic, 8);
+        h.version = trajectory_version;
+        h.dim = dim;
+        h.L = L;
+        h.flags = (compress ? 1 : 0) | geometry_id(geometry) << 8;
+        h.T = T;
+        h.J = J;
+        h.seed = seed;
+        h.n_sites = 1;
+        for (int a = 0; a < dim; ++a) h.n_sites *= L;
+        h.index_offset = 0;
+
+        if (append && filesystem::exists(path)) {
+            TrajectoryHeader old;
+            uint64_t end = 0;
+            {
+                ifstream in(path, ios::binary);
+                if (!read_trajectory_index(in, old, times, offsets, end) || old.dim != h.dim || old.L != h.L
+                    || trajectory_geometry(old) != trajectory_geometry(h) || old.T != h.T || old.J != h.J) {
+                    cerr << "轨迹文件无法读取或与当前参数不匹配: " << path << endl;
+                    return;
+                }
+            }
+            h.seed = old.seed;
+            if (old.version < 2) { h.version = old.version; h.flags &= 1; } // 版本 1 的文件保持原格式
+            error_code ec;
+            filesystem::resize_file(path, end, ec);
+            if (ec) { cerr << "轨迹文件无法截断: " << path << ": " << ec.message() << endl; return; }
+            out.open(path, ios::binary | ios::in | ios::out);
+            write_header();
+            out.seekp(end);
+        } else {
+            out.open(path, ios::binary | ios::trunc);
+            write_header();
+        }
+    }
+
+    ~TrajectoryWriter() { close(); }
+
+    bool ok() const { return out.is_open() && out.good(); }
+    int frames() const { return (int)times.size(); }
+
+    template <class Sites>
+    void write_frame(int mcs, const Sites& sites, int v_pos) {
+        if (!ok()) return;
+        vector<uint64_t> words = pack_sites(sites, (int)h.n_sites);
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(words.data());
+        size_t raw_bytes = words.size() * sizeof(uint64_t);
+
+        FrameHeader f{frame_tag, 0, (uint64_t)mcs, v_pos, raw_bytes};
+        vector<uint8_t> packed;
+        if (compress) {
+            packed = rle_encode(raw, raw_bytes);
+            if (packed.size() < raw_bytes) {
+                f.encoding = 1;
+                f.bytes = packed.size();
+                raw = packed.data();
+            }
+        }
+        times.push_back(mcs);
+        offsets.push_back(out.tellp());
+        out.write(reinterpret_cast<const char*>(&f), sizeof(f));
+        out.write(reinterpret_cast<const char*>(raw), f.bytes);
+        static const char pad[8] = {};
+        out.write(pad, (8 - f.bytes % 8) % 8);
+    }
+
+    void flush() { if (out.is_open()) out.flush(); }
+
+    // 在末尾写索引并回填文件头中的 index_offset
+    void close() {
+        if (!out.is_open()) return;
+        h.index_offset = out.tellp();
+        uint32_t tag[2] = {index_tag, 0};
+        uint64_t n = times.size();
+        out.write(reinterpret_cast<const char*>(tag), sizeof(tag));
+        out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+        for (size_t k = 0; k < times.size(); ++k) {
+            uint64_t entry[2] = {times[k], offsets[k]};
+            out.write(reinterpret_cast<const char*>(entry), sizeof(entry));
+        }
+        write_header();
+        out.close();
+    }
+
+private:
+    string path;
+    bool compress;
+    TrajectoryHeader h;
+    ofstream out;
+    vector<uint64_t> times, offsets;
+
+    void write_header() {
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.seekp(0, ios::end);
+    }
+};
+
+// 随机访问读取: 按 mcs 查找帧并解码为 vector<int> (-1/0/+1) 或 PackedSites
+class TrajectoryReader {
+public:
+    TrajectoryHeader header{};
+    vector<uint64_t> times, offsets;
+
+    explicit TrajectoryReader(const string& path) : in(path, ios::binary) {
+        uint64_t end;
+        if (!in.is_open() || !read_trajectory_index(in, header, times, offsets, end)) {
+            cerr << "无法读取轨迹文件: " << path << endl;
+            in.close();
+        }
+    }
+
+    bool ok() const { return in.is_open(); }
+    int frames() const { return (int)times.size(); }
+    int find(uint64_t mcs) const {
+        for (size_t k = 0; k < times.size(); ++k) if (times[k] == mcs) return (int)k;
+        return -1;
+    }
+
+    // 解码第 k 帧; v_pos 非空时返回空位位置 (-1 表示没有空位)
+    template <class Sites>
+    bool read_frame(int k, Sites& sites, int* v_pos = nullptr) {
+        FrameHeader f;
+        in.clear();
+        in.seekg(offsets[k]);
+        in.read(reinterpret_cast<char*>(&f), sizeof(f));
+        vector<uint64_t> words((header.n_sites + 63) / 64);
+        uint8_t* raw = reinterpret_cast<uint8_t*>(words.data());
+        size_t raw_bytes = words.size() * sizeof(uint64_t);
+        if (f.encoding == 0) {
+            if (f.bytes != raw_bytes) return false;
+            in.read(reinterpret_cast<char*>(raw), raw_bytes);
+        } else {
+            vector<uint8_t> packed(f.bytes);
+            in.read(reinterpret_cast<char*>(packed.data()), f.bytes);
+            if (!rle_decode(packed.data(), packed.size(), raw, raw_bytes)) return false;
+        }
+        if (!in) return false;
+        unpack_sites(words, (int)header.n_sites, (int)f.vacancy, sites);
+        if (v_pos) *v_pos = (int)f.vacancy;
+        return true;
+    }
+
+private:
+    ifstream in;
+};
+
+#endif
@@ -0,0 +1,95 @@
+import numpy as np
+
+# 读取 C++ 端 trajectory.h 写出的二进制轨迹文件 (trajectory.bin)
+# 文件整体以 numpy.memmap 映射, 未压缩帧直接在映射上解包, 不做文本解析
+
+HEADER = np.dtype([('magic', 'S8'), ('version', '<u4'), ('dim', '<u4'), ('L', '<u4'), ('flags', '<u4'),
+                   ('T', '<f8'), ('J', '<f8'), ('seed', '<u8'), ('n_sites', '<u8'), ('index_offset', '<u8')])
+FRAME = np.dtype([('tag', '<u4'), ('encoding', '<u4'), ('mcs', '<u8'), ('vacancy', '<i8'), ('bytes', '<u8')])
+FRAME_TAG = 0x454D5246
+INDEX_TAG = 0x58444E49
+GEOMETRIES = {0: ('square', 'cubic'), 1: ('triangular',) * 2, 2: ('bcc',) * 2, 3: ('fcc',) * 2}  # 见 geometry_id
+
+
+class Trajectory:
+    def __init__(self, path):
+        self.data = np.memmap(path, dtype=np.uint8, mode='r')
+        h = self.data[:HEADER.itemsize].view(HEADER)[0]
+        if h['magic'] != b'VMDTRAJ1':
+            raise ValueError(f"不是轨迹文件: {path}")
+        self.dim, self.L = int(h['dim']), int(h['L'])
+        # flags 第 8-15 位为几何编号 (版本 2 起); 版本 1 的文件按正方 / 简单立方读取
+        gid = (int(h['flags']) >> 8) & 0xFF if int(h['version']) >= 2 else 0
+        self.geometry = GEOMETRIES[gid][self.dim - 2]
+        self.T, self.J, self.seed = float(h['T']), float(h['J']), int(h['seed'])
+        self.n_sites = int(h['n_sites'])
+        self.shape = (self.L,) * self.dim
+        self.times, self.offsets = self._read_index(int(h['index_offset']))
+
+    def _read_index(self, index_offset):
+        size = len(self.data)
+        # 优先使用末尾索引; 程序被中断时没有索引, 顺序扫描帧记录
+        if HEADER.itemsize <= index_offset and index_offset + 16 <= size:
+            tag = self.data[index_offset:index_offset + 4].view('<u4')[0]
+            n = int(self.data[index_offset + 8:index_offset + 16].view('<u8')[0])
+            if tag == INDEX_TAG and index_offset + 16 + 16 * n == size:
+                entries = self.data[index_offset + 16:size].view('<u8').reshape(n, 2)
+                return entries[:, 0].astype(int).tolist(), entries[:, 1].astype(int).tolist()
+        times, offsets = [], []
+        pos = HEADER.itemsize
+        while pos + FRAME.itemsize <= size:
+            f = self.data[pos:pos + FRAME.itemsize].view(FRAME)[0]
+            nxt = pos + FRAME.itemsize + ((int(f['bytes']) + 7) & ~7)
+            if f['tag'] != FRAME_TAG or nxt > size:
+                break
+            times.append(int(f['mcs']))
+            offsets.append(pos)
+            pos = nxt
+        return times, offsets
+
+    def __len__(self):
+        return len(self.times)
+
+    def frame(self, k):
+        """第 k 帧: 形状 (L,)*D 的 int8 数组, A = +1, B = -1, 空位 = 0"""
+        pos = self.offsets[k]
+        f = self.data[pos:pos + FRAME.itemsize].view(FRAME)[0]
+        payload = self.data[pos + FRAME.itemsize:pos + FRAME.itemsize + int(f['bytes'])]
+        if f['encoding'] == 1:
+            payload = rle_decode(payload, (self.n_sites + 63) // 64 * 8)
+        bits = np.unpackbits(payload, bitorder='little')[:self.n_sites]
+        lattice = 2 * bits.astype(np.int8) - 1
+        if f['vacancy'] >= 0:  # Kawasaki 轨迹没有空位
+            lattice[int(f['vacancy'])] = 0
+        return lattice.reshape(self.shape)
+
+    def at(self, mcs):
+        """按 MCS 取帧"""
+        return self.frame(self.times.index(mcs))
+
+
+def rle_decode(p, n):
+    """与 trajectory.h 中 rle_decode 相同的字节游程解码"""
+    out = np.empty(n, dtype=np.uint8)
+    p = np.asarray(p)
+    i = o = 0
+    while i < len(p):
+        c = int(p[i])
+        i += 1
+        if c < 128:
+            out[o:o + c + 1] = p[i:i + c + 1]
+            i += c + 1
+            o += c + 1
+        else:
+            out[o:o + c - 125] = p[i]
+            i += 1
+            o += c - 125
+    return out
+
+
+if __name__ == "__main__":
+    import sys
+    traj = Trajectory(sys.argv[1] if len(sys.argv) > 1 else '../output/trajectory.bin')
+    print(f"D = {traj.dim}, {traj.geometry}, L = {traj.L}, T = {traj.T}, J = {traj.J}, seed = {traj.seed}, frames = {len(traj)}")
+    for t, off in zip(traj.times, traj.offsets):
+        print(f"t = {t}\toffset = {off}")
@@ -0,0 +1,32 @@
+#include "vacancy_engine.h"
+#include "trajectory.h"
+
+using namespace std;
+
+// 轨迹文件小工具
+// 用法: ./trajectory_tool <trajectory.bin>                    列出文件头与各帧
+//       ./trajectory_tool <trajectory.bin> <mcs> <out.txt>    导出一帧为旧的文本快照格式
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cerr << "用法: " << argv[0] << " <trajectory.bin> [mcs out.txt]" << endl;
+        return 1;
+    }
+    TrajectoryReader reader(argv[1]);
+    if (!reader.ok()) return 1;
+    const TrajectoryHeader& h = reader.header;
+
+    if (argc < 4) {
+        cout << "D = " << h.dim << ", " << geometry_name(trajectory_geometry(h), h.dim) << ", L = " << h.L << ", T = " << h.T << ", J = " << h.J
+             << ", seed = " << h.seed << ", frames = " << reader.frames() << endl;
+        for (int k = 0; k < reader.frames(); ++k) cout << "t = " << reader.times[k] << "\toffset = " << reader.offsets[k] << endl;
+        return 0;
+    }
+
+    int k = reader.find(stoull(argv[2]));
+    if (k < 0) { cerr << "没有 t = " << argv[2] << " 的帧" << endl; return 1; }
+    vector<int> sites;
+    if (!reader.read_frame(k, sites)) { cerr << "帧数据损坏" << endl; return 1; }
+    if (h.dim == 2) write_lattice(Lattice<2>(h.L), sites, argv[3]);
+    else write_lattice(Lattice<3>(h.L), sites, argv[3]);
+    return 0;
+}
@@ -0,0 +1,303 @@
+#ifndef VACANCY_ENGINE_H
+#define VACANCY_ENGINE_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <random>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include "lattice.h"
+#include "vacancy_kernel.h"
+
+using namespace std;
+
+// 按坐标的行优先顺序遍历全部格点, 坐标按里程表方式递增 (无除法);
+// Morton 顺序时索引随坐标一起沿轴走一步 (膨胀整数加法, 见 lattice.h), 仍无乘除
+template <class Lat, class F>
+void for_each_site(const Lat& lat, F&& f) {
+    typename Lat::Coord c{};
+    int L = lat.size(), N = lat.sites();
+    if constexpr (Lat::row_major) {
+        for (int i = 0; i < N; ++i) {
+            f(i, c);
+            for (int a = Lat::dim - 1; a >= 0; --a) {
+                if (++c[a] < L) break;
+                c[a] = 0;
+            }
+        }
+    } else {
+        for (int k = 0, i = 0; k < N; ++k) {
+            f(i, c);
+            for (int a = Lat::dim - 1; a >= 0; --a) {
+                i = lat.neighbor(c, i, 2 * a); // 到 L 时已按周期边界回到 0
+                if (++c[a] < L) break;
+                c[a] = 0;
+            }
+        }
+    }
+}
+
+// 格点顺序转换: out 为按坐标行优先重排的构型 (Lat 为行优先时原样复制).
+// 轨迹快照、检查点与只支持行优先的测量模块 (StructureFactor / DomainLabeler) 使用
+template <class Lat>
+void to_row_major(const Lat& lat, const vector<int>& in, vector<int>& out) {
+    if constexpr (Lat::row_major) { out = in; return; }
+    out.resize(in.size());
+    int k = 0;
+    for_each_site(lat, [&](int i, const typename Lat::Coord&) { out[k++] = in[i]; });
+}
+
+template <class Lat>
+void from_row_major(const Lat& lat, const vector<int>& in, vector<int>& out) {
+    if constexpr (Lat::row_major) { out = in; return; }
+    out.resize(in.size());
+    int k = 0;
+    for_each_site(lat, [&](int i, const typename Lat::Coord&) { out[i] = in[k++]; });
+}
+
+template <class Lat>
+void to_row_major(const Lat& lat, const PackedSites& in, PackedSites& out) {
+    if constexpr (Lat::row_major) { out = in; return; }
+    out.assign(in.size());
+    int k = 0;
+    for_each_site(lat, [&](int i, const typename Lat::Coord&) {
+        out.set_bit(k, in.bit(i));
+        if (i == in.vacancy) out.vacancy = k;
+        ++k;
+    });
+}
+
+template <class Lat>
+void from_row_major(const Lat& lat, const PackedSites& in, PackedSites& out) {
+    if constexpr (Lat::row_major) { out = in; return; }
+    out.assign(in.size());
+    int k = 0;
+    for_each_site(lat, [&](int i, const typename Lat::Coord&) {
+        out.set_bit(i, in.bit(k));
+        if (k == in.vacancy) out.vacancy = i;
+        ++k;
+    });
+}
+
+// 初始化晶格 (Requirement a): 50% A (+1) / 50% B (-1) 随机排列, 再注入一个空位
+template <class Lat, class URBG>
+void fill_random_alloy(const Lat& lat, vector<int>& sites, int& v_pos, URBG& g) {
+    int N = lat.sites();
+    sites.assign(N, -1);
+    fill(sites.begin(), sites.begin() + N / 2, 1);
+    shuffle_range(sites.begin(), sites.end(), g);
+    v_pos = (int)uniform_below(g, N);
+    sites[v_pos] = 0; // 注入空位
+}
+
+// 位压缩存储: 随机选出 N/2 个 A 原子 (重复则重抽), 不需要 N 个 int 的中间数组
+template <class Lat, class URBG>
+void fill_random_alloy(const Lat& lat, PackedSites& sites, int& v_pos, URBG& g) {
+    int N = lat.sites();
+    sites.assign(N);
+    for (int placed = 0; placed < N / 2;) {
+        int i = (int)uniform_below(g, N);
+        if (!sites.bit(i)) { sites.set_bit(i, 1); ++placed; }
+    }
+    v_pos = (int)uniform_below(g, N);
+    sites.set_bit(v_pos, 0); // 注入空位
+    sites.vacancy = v_pos;
+}
+
+// 全局能量 (以 J 为单位): 每条 A-A/B-B 键 -1, A-B 键 +1, 与空位相连的键不计
+template <class Lat, class Sites>
+long long total_energy_scan(const Lat& lat, const Sites& sites) {
+    long long total = 0;
+    for_each_site(lat, [&](int i, const typename Lat::Coord& c) {
+        if (sites[i] != 0) total -= sites[i] * lat.neighbor_sum(sites, c, i);
+    });
+    return total / 2;
+}
+
+template <class Lat, class Sites>
+long long total_energy_bonds(const Lat& lat, const Sites& sites) {
+    return total_energy_scan(lat, sites);
+}
+
+// 位压缩存储: 按字异或 + popcount 统计异类键 U, 再扣除空位的 z 条键;
+// 原子-原子键共 B = N*D - z 条, E = U - (B - U) = 2U - B
+template <class Lat>
+long long total_energy_bonds(const Lat& lat, const PackedSites& sites) {
+    // 非超立方几何还有坐标轴以外的键, 逐点统计
+    if (!Lat::geometry::axial || !packed_popcount_ok(lat)) return total_energy_scan(lat, sites);
+    long long unlike = 0;
+    for (int a = 0; a < Lat::dim; ++a) unlike += packed_unlike_pairs(lat, sites, a, 1);
+    int v = sites.vacancy;
+    typename Lat::Coord vc = lat.coords(v);
+    for (int dir = 0; dir < Lat::z; ++dir) unlike -= sites.bit(v) != sites.bit(lat.neighbor(vc, v, dir));
+    long long bonds = (long long)lat.sites() * Lat::dim - Lat::z;
+    return 2 * unlike - bonds;
+}
+
+// 基于能量的畴尺寸: 完全有序时 E/N = -z/2, 界面能与畴尺寸成反比 (单位为最近邻距离)
+template <class Lat>
+inline double energy_domain_size(const Lat& lat, long long energy) {
+    const double half_z = Lat::z / 2.0;
+    return half_z / ((double)energy / lat.sites() + half_z);
+}
+
+// 沿各坐标轴方向的对关联函数 C(r), r = 1..L/2 (符合 Project 15.45 Requirement b)
+template <class Lat, class Sites>
+vector<double> axial_correlation_scan(const Lat& lat, const Sites& sites) {
+    int L = lat.size();
+    int max_r = L / 2;
+    vector<double> C(max_r + 1, 0.0);
+    vector<long long> count(max_r + 1, 0);
+    vector<int> shift(L);
+    for (int a = 0; a < Lat::dim; ++a) {
+        for (int r = 1; r <= max_r; ++r) {
+            // shift[c] = 坐标 c 平移 r 后的索引增量, 内层循环无取模
+            for (int c = 0; c < L; ++c) shift[c] = lat.offset(a, (c + r) % L) - lat.offset(a, c);
+            long long sum = 0, cnt = 0;
+            for_each_site(lat, [&](int i, const typename Lat::Coord& c) {
+                int s = sites[i];
+                int t = sites[i + shift[c[a]]];
+                sum += s * t;
+                cnt += (s != 0) & (t != 0);
+            });
+            C[r] += sum;
+            count[r] += cnt;
+        }
+    }
+    for (int r = 1; r <= max_r; ++r) if (count[r] > 0) C[r] /= count[r];
+    C[0] = 1.0;
+    return C;
+}
+
+template <class Lat, class Sites>
+vector<double> axial_correlation(const Lat& lat, const Sites& sites) {
+    return axial_correlation_scan(lat, sites);
+}
+
+// 位压缩存储: s_i s_j = 1 - 2 [位不同], 每个 (a, r) 一遍 popcount;
+// 含空位的两对 (v, v+r) 与 (v-r, v) 单独扣除
+template <class Lat>
+vector<double> axial_correlation(const Lat& lat, const PackedSites& sites) {
+    if (!packed_popcount_ok(lat)) return axial_correlation_scan(lat, sites);
+    int L = lat.size();
+    int max_r = L / 2;
+    vector<double> C(max_r + 1, 0.0);
+    int v = sites.vacancy;
+    typename Lat::Coord vc = lat.coords(v);
+    long long pairs = lat.sites() - 2;
+    for (int r = 1; r <= max_r; ++r) {
+        long long sum = 0;
+        for (int a = 0; a < Lat::dim; ++a) {
+            long long unlike = packed_unlike_pairs(lat, sites, a, r);
+            typename Lat::Coord fwd = vc, bwd = vc;
+            fwd[a] = (vc[a] + r) % L;
+            bwd[a] = (vc[a] - r + L) % L;
+            unlike -= sites.bit(v) != sites.bit(lat.index(fwd));
+            unlike -= sites.bit(v) != sites.bit(lat.index(bwd));
+            sum += pairs - 2 * unlike;
+        }
+        C[r] = (double)sum / (pairs * Lat::dim);
+    }
+    C[0] = 1.0;
+    return C;
+}
+
+// 存储 C(r): 每行 "r\tC(r)"
+inline void write_C_r(const vector<double>& Cr, const string& filename) {
+    ofstream out(filename);
+    if (out.is_open()) {
+        for (size_t r = 0; r < Cr.size(); ++r) {
+            out << r << "\t" << fixed << setprecision(6) << Cr[r] << "\n";
+        }
+    } else {
+        cerr << "无法打开文件: " << filename << " (请确保 output 文件夹已创建)" << endl;
+    }
+}
+
+// 存储晶格快照: 2D 每行 L 个格点, 3D 按行优先顺序写成一行 (Python 端再 reshape); 与格点的存储顺序无关
+template <class Lat, class Sites>
+void write_lattice(const Lat& lat, const Sites& sites, const string& filename) {
+    ofstream out(filename);
+    if (!out.is_open()) return;
+    int L = lat.size();
+    for_each_site(lat, [&](int i, const typename Lat::Coord& c) {
+        out << sites[i] << " ";
+        if (Lat::dim == 2 && c[1] == L - 1) out << "\n";
+    });
+}
+
+// 空位介导动力学引擎: 驱动程序只需实例化 VacancyEngine<2, 128> / VacancyEngine<3, 64>,
+// 或用 VacancyEngine<D> 在运行期指定 L; Sites = PackedSites 时为每格点 1 位的压缩存储;
+// G 为晶格几何 (geometry.h), 如 VacancyEngine<3, 64, vector<int>, FCC>;
+// O 为格点存储顺序 (lattice.h), 如 VacancyEngine<3, 256, vector<int>, HyperCubic<3>, Morton>
+template <int D, int CL = 0, class Sites = vector<int>, class G = HyperCubic<D>, class O = RowMajor>
+class VacancyEngine {
+public:
+    using lattice_type = Lattice<D, CL, G, O>;
+    using Coord = typename lattice_type::Coord;
+
+    lattice_type lat;
+    Sites sites;
+    Coord vc{};
+    int v_pos = 0;
+    long long energy = 0; // 以 J 为单位的整数能量
+    double T, J;
+    MetropolisTable table;
+    bool rejection_free = false; // true 时 mcs() 使用无拒绝 (BKL) 核
+
+    VacancyEngine(int L, double T_, double J_)
+        : lat(L), T(T_), J(J_), table(lattice_type::z, T_, J_) {}
+
+    int size() const { return lat.size(); }
+    int sites_count() const { return lat.sites(); }
+
+    template <class URBG>
+    void initialize(URBG& g) {
+        fill_random_alloy(lat, sites, v_pos, g);
+        vc = lat.coords(v_pos);
+        energy = total_energy_bonds(lat, sites);
+    }
+
+    // n_attempts 次空位跳跃尝试; 一个 MCS 为 N 次尝试. probe 见 vacancy_kernel.h / instrumentation.h
+    template <class URBG, class Probe = NullProbe>
+    void sweep(long long n_attempts, URBG& g, Probe&& probe = Probe()) {
+        energy += vacancy_sweep(lat, table, sites, vc, v_pos, n_attempts, g, probe);
+    }
+
+    // 无拒绝 (BKL) 版本: 同一离散时间动力学, 低温下大部分尝试被拒绝时快得多
+    template <class URBG, class Probe = NullProbe>
+    void sweep_rejection_free(long long n_attempts, URBG& g, Probe&& probe = Probe()) {
+        energy += vacancy_sweep_rejection_free(lat, table, sites, vc, v_pos, n_attempts, g, probe);
+    }
+
+    // 按 rejection_free 选择核的 n_attempts 次尝试; mcs() 即 N 次
+    template <class URBG, class Probe = NullProbe>
+    void attempts(long long n_attempts, URBG& g, Probe&& probe = Probe()) {
+        if (rejection_free) sweep_rejection_free(n_attempts, g, probe);
+        else sweep(n_attempts, g, probe);
+    }
+
+    template <class URBG, class Probe = NullProbe>
+    void mcs(URBG& g, Probe&& probe = Probe()) {
+        attempts(lat.sites(), g, probe);
+    }
+
+    // 基于能量的畴尺寸 R = (z/2) / (<E>/N + z/2), 基态 E/N = -z/2 (2D 正方即 2/(E/N + 2))
+    double R_energy() const {
+        return energy_domain_size(lat, energy);
+    }
+
+    // 原子-原子异类键数 U, 由 E = 2U - (N z/2 - z) 得到, 与 energy 一样随每次跳跃增量更新
+    long long unlike_bonds() const {
+        long long bonds = (long long)lat.sites() * lattice_type::bond_dirs - lattice_type::z;
+        return (energy + bonds) / 2;
+    }
+
+    vector<double> correlation() const { return axial_correlation(lat, sites); }
+    void save_lattice(const string& filename) const { write_lattice(lat, sites, filename); }
+};
+
+#endif
@@ -0,0 +1,179 @@
+#ifndef VACANCY_KERNEL_H
+#define VACANCY_KERNEL_H
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include "packed_sites.h"
+#include "rng.h"
+
+using namespace std;
+
+// Metropolis 接受率查表 (整数阈值)
+// 原子 s 从邻居 n 跳入空位 v 时, 以 J 为单位的能量差为
+//   de = s * (S_n - S_v) + 1,   S_x 为 x 周围 z 个邻居的自旋和 (空位计 0)
+// de 只取 [-2(z-1), 2(z-1)] 内的偶数个整数值, 因此可以一次性预计算
+// de > 0 时接受条件 exp(-de*J/T) > u 等价于 32 位随机整数 < threshold[de]
+// (其他动力学可传入自己的 max_de, 如 Kawasaki 交换为 4(z-1), 见 kawasaki_engine.h)
+struct MetropolisTable {
+    int max_de = 0;
+    vector<uint32_t> threshold;
+    vector<double> prob; // 接受概率 min(1, exp(-de*J/T)), 按 de + max_de 索引 (无拒绝算法使用)
+
+    MetropolisTable() = default;
+    MetropolisTable(int z, double T, double J, int max_de_ = 0)
+        : max_de(max_de_ > 0 ? max_de_ : 2 * (z - 1)), threshold(max_de + 1, 0), prob(2 * max_de + 1, 1.0) {
+        for (int de = 1; de <= max_de; ++de) {
+            double p = exp(-de * J / T);
+            threshold[de] = static_cast<uint32_t>(min(p * 4294967296.0, 4294967295.0));
+            prob[de + max_de] = p;
+        }
+    }
+
+    inline double probability(int de) const { return prob[de + max_de]; }
+
+    // de <= 0 时直接接受, 不消耗随机数 (与原 Metropolis 循环一致)
+    template <class URBG>
+    inline bool accept(int de, URBG& gen) const {
+        return de <= 0 || static_cast<uint32_t>(gen()) < threshold[de];
+    }
+};
+
+// 跳跃探针: 内核对每次尝试调用 hop(de, 是否接受, 方向), 无拒绝核对跳过的尝试调用 skipped(n),
+// 每次被接受的跳跃调用 moved(from, to, s) (原子 s 从坐标 from 移到空位 to);
+// 快进核 (fast_forward.h) 把纯畴内 n 次必被接受的 de = 0 跳跃合成一次 moved 与 walked(n, 净位移).
+// NullProbe 的方法为空, 调用在编译期被消除, 不插桩时内核与原来完全相同; 插桩版本见 instrumentation.h,
+// 增量维护的粗粒化观测量见 coarse_grain.h
+struct NullProbe {
+    static constexpr bool enabled = false;
+    NullProbe() = default;
+    explicit NullProbe(const MetropolisTable&) {}
+    inline void hop(int, bool, int) {}
+    inline void skipped(long long) {}
+    template <class Coord>
+    inline void moved(const Coord&, const Coord&, int) {}
+    template <class Disp>
+    inline void walked(long long, const Disp&) {}
+};
+
+// 两个探针串联 (如插桩 + 粗粒化观测量): engine.mcs(gen, ProbePair<P1, P2>{p1, p2})
+template <class P1, class P2>
+struct ProbePair {
+    static constexpr bool enabled = P1::enabled || P2::enabled;
+    P1& first;
+    P2& second;
+    inline void hop(int de, bool ok, int dir) { first.hop(de, ok, dir); second.hop(de, ok, dir); }
+    inline void skipped(long long n) { first.skipped(n); second.skipped(n); }
+    template <class Coord>
+    inline void moved(const Coord& from, const Coord& to, int s) { first.moved(from, to, s); second.moved(from, to, s); }
+    template <class Disp>
+    inline void walked(long long n, const Disp& d) { first.walked(n, d); second.walked(n, d); }
+};
+
+// 空位跳跃核: 整数键计数 + 查表接受, 对任意 Lattice<D, L> 与存储 (vector<int> / PackedSites) 通用
+// 执行 n_attempts 次空位跳跃尝试, 返回被接受跳跃的能量变化总和 (以 J 为单位)
+template <class Lat, class Sites, class URBG, class Probe = NullProbe>
+long long vacancy_sweep(const Lat& lat, const MetropolisTable& table, Sites& sites,
+                        typename Lat::Coord& vc, int& v_pos, long long n_attempts, URBG& gen,
+                        Probe&& probe = Probe()) {
+    long long de_total = 0;
+    typename Lat::Coord vc_ = vc; int v_pos_ = v_pos;
+    int v_sum = lat.neighbor_sum(sites, vc_, v_pos_);
+    for (long long step = 0; step < n_attempts; ++step) {
+        // 乘法-移位把 32 位随机数映射到 [0, z), 无除法
+        int dir = static_cast<int>((static_cast<uint64_t>(static_cast<uint32_t>(gen())) * Lat::z) >> 32);
+        typename Lat::Coord nc = vc_;
+        lat.advance(nc, dir);
+        int n_idx = lat.neighbor(vc_, v_pos_, dir);
+
+        int s = sites[n_idx];
+        int n_sum = lat.neighbor_sum(sites, nc, n_idx); // 此时 v 仍是空位, 计 0
+        int de = s * (n_sum - v_sum) + 1;
+
+        bool accepted = table.accept(de, gen);
+        probe.hop(de, accepted, dir);
+        if (accepted) {
+            probe.moved(nc, vc_, s);
+            move_atom(sites, n_idx, v_pos_, s);
+            de_total += de;
+            v_pos_ = n_idx;
+            vc_ = nc;
+            v_sum = n_sum + s; // 新空位的邻居和: 原 n 的邻居, v 处已变为 s
+        }
+    }
+    vc = vc_; v_pos = v_pos_;
+    return de_total;
+}
+
+// [0, 1) 内 53 位精度的均匀随机数 (与 genrand_res53 相同的构造)
+template <class URBG>
+inline double uniform53(URBG& gen) {
+    uint64_t a = static_cast<uint32_t>(gen()) >> 5, b = static_cast<uint32_t>(gen()) >> 6;
+    return (a * 67108864.0 + b) / 9007199254740992.0;
+}
+
+// 到下一次成功为止的尝试次数 K ~ Geometric(P), K >= 1 (每次尝试成功概率为 P);
+// 超过 remaining 时返回 remaining + 1. P >= 1 时不消耗随机数
+template <class URBG>
+inline long long geometric_attempts(double P, long long remaining, URBG& gen) {
+    if (P >= 1.0) return 1;
+    double k = floor(log1p(-uniform53(gen)) / log1p(-P));
+    return k >= (double)remaining ? remaining + 1 : 1 + (long long)k;
+}
+
+// 无拒绝 (n-fold way / BKL) 空位核: 与 vacancy_sweep 是同一个离散时间 Metropolis 马尔可夫链,
+// 只是跳过了所有被拒绝的尝试.
+// 在当前构型下, 一次尝试选中方向 d 并被接受的概率为 r_d = p_d / z, 总接受概率 P = Σ r_d.
+// 到下一次被接受为止的尝试次数 K 服从几何分布 P(K = k) = (1-P)^{k-1} P, 被接受的方向
+// 按 r_d / P 选取. 若 K 超出剩余的尝试数, 则剩余尝试全部被拒绝 (构型不变);
+// 由几何分布的无记忆性, 下一段从头抽取 K 仍然精确, 因此 t = 2^n 采样网格不受影响.
+// 探针只能看到被接受的跳跃; 被跳过的尝试不知道各自的方向与 de, 只按总数计入 skipped
+template <class Lat, class Sites, class URBG, class Probe = NullProbe>
+long long vacancy_sweep_rejection_free(const Lat& lat, const MetropolisTable& table, Sites& sites,
+                                       typename Lat::Coord& vc, int& v_pos, long long n_attempts, URBG& gen,
+                                       Probe&& probe = Probe()) {
+    constexpr int z = Lat::z;
+    long long de_total = 0;
+    long long remaining = n_attempts;
+    int v_sum = lat.neighbor_sum(sites, vc, v_pos);
+    while (remaining > 0) {
+        // 1. z 个方向的接受率
+        int n_idx[z], n_sum[z], de[z];
+        double rate[z], P = 0.0;
+        for (int d = 0; d < z; ++d) {
+            typename Lat::Coord nc = vc;
+            lat.advance(nc, d);
+            n_idx[d] = lat.neighbor(vc, v_pos, d);
+            n_sum[d] = lat.neighbor_sum(sites, nc, n_idx[d]);
+            de[d] = sites[n_idx[d]] * (n_sum[d] - v_sum) + 1;
+            rate[d] = table.probability(de[d]);
+            P += rate[d];
+        }
+        P /= z;
+
+        // 2. 驻留的尝试次数 K ~ Geometric(P)
+        long long K = geometric_attempts(P, remaining, gen);
+        if (K > remaining) { probe.skipped(remaining); break; } // 本段剩余尝试全部被拒绝
+        remaining -= K;
+        probe.skipped(K - 1);
+
+        // 3. 按 rate 选择方向并执行跳跃
+        double x = uniform53(gen) * P * z;
+        int d = 0;
+        while (d < z - 1 && x >= rate[d]) { x -= rate[d]; ++d; }
+        int s = sites[n_idx[d]];
+        typename Lat::Coord nc = vc;
+        lat.advance(nc, d);
+        probe.hop(de[d], true, d);
+        probe.moved(nc, vc, s);
+        move_atom(sites, n_idx[d], v_pos, s);
+        de_total += de[d];
+        vc = nc;
+        v_pos = n_idx[d];
+        v_sum = n_sum[d] + s;
+    }
+    return de_total;
+}
+
+#endif